@@ -0,0 +1,24 @@
+/*
+ * Writes a synthetic l1profile (see profile_gen.hpp) to stdout.
+ *
+ * Usage: l1gen-profile [chipsets] [bands] [props] [seed]
+ */
+#include "profile_gen.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    ProfileGenOptions opt;
+    if (argc > 1) opt.chipsets = strtoul(argv[1], nullptr, 10);
+    if (argc > 2) opt.bands = strtoul(argv[2], nullptr, 10);
+    if (argc > 3) opt.props = strtoul(argv[3], nullptr, 10);
+    if (argc > 4) opt.seed = (uint32_t)strtoul(argv[4], nullptr, 10);
+    if (argc > 5 || opt.chipsets == 0 || opt.bands == 0) {
+        fprintf(stderr, "Usage: l1gen-profile [chipsets] [bands] [props] [seed]\n");
+        return 1;
+    }
+
+    std::string text = gen_profile(opt);
+    return fwrite(text.data(), 1, text.size(), stdout) == text.size() ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * Interface / device lookup microbenchmark: std::unordered_map versus the
+ * minimal perfect hash used by L1Snapshot and the compiled image.
+ *
+ * For each profile size (number of bands, two per INDEX block) it reports
+ * ns per lookup over the interface and device key sets for:
+ *   umap    std::unordered_map<std::string_view, ...>::find, the old path
+ *   phf     utils::PerfectHash slot + one confirming comparison
+ *   parsed  L1Snapshot::if_prop_view() on a parsed profile (phf + props)
+ *   image   the same lookup on a compiled image (phf + props)
+ * plus the time to build the hashes. Every probe set mixes in 25% misses.
+ *
+ * Usage: l1bench-hash [max_bands]
+ */
+#include "l1parser.hpp"
+#include "../lib/l1image.hpp"
+#include "../utils/perfecthash.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+static std::string make_profile(size_t bands) {
+    std::string out = "Default\n";
+    size_t blocks = (bands + 1) / 2;
+    for (size_t b = 0; b < blocks; ++b) {
+        std::string idx = "INDEX" + std::to_string(b);
+        std::string n = std::to_string(b);
+        bool dbdc = (b + 1) * 2 <= bands;
+        out += idx + "=MT7996\n";
+        out += idx + "_main_ifname=ra" + n + "x" + (dbdc ? ";rai" + n + "x" : "") + "\n";
+        out += idx + "_ext_ifname=ra" + n + "_" + (dbdc ? ";rai" + n + "_" : "") + "\n";
+        out += idx + "_apcli_ifname=apcli" + n + "_" + (dbdc ? ";apclii" + n + "_" : "") + "\n";
+        out += idx + "_nvram_zone=dev" + n + (dbdc ? ";devi" + n : "") + "\n";
+        out += idx + "_profile_path=/etc/wireless/mediatek/b" + n + ".dat" + (dbdc ? ";/etc/wireless/mediatek/bi" + n + ".dat" : "") + "\n";
+    }
+    return out;
+}
+
+template <typename Fn>
+static double ns_per_op(size_t ops, Fn fn) {
+    using clock = std::chrono::steady_clock;
+    size_t iters = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    do {
+        fn();
+        iters++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < 0.2);
+    return elapsed * 1e9 / (double)(iters * ops);
+}
+
+// Probe list: every key once plus 25% near-miss names, shuffled
+static std::vector<std::string> probes_for(const std::vector<std::string_view>& keys) {
+    std::vector<std::string> probes(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size() / 4; ++i) probes.push_back(std::string(keys[i]) + "z");
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(1));
+    return probes;
+}
+
+int main(int argc, char* argv[]) {
+    size_t max_bands = argc > 1 ? strtoul(argv[1], nullptr, 10) : 256;
+    std::string path = "/tmp/l1bench-hash." + std::to_string(getpid()) + ".dat";
+    std::string img_path = path + ".img";
+
+    printf("%6s %6s | %19s | %19s | %15s | %8s\n", "", "", "if ns/lookup", "dev ns/lookup", "if2zone ns", "build");
+    printf("%6s %6s | %9s %9s | %9s %9s | %7s %7s | %8s\n", "bands", "ifs", "umap", "phf", "umap", "phf",
+           "parsed", "image", "us");
+
+    volatile size_t sink = 0;
+    for (size_t bands = 1; bands <= max_bands; bands *= 2) {
+        {
+            std::ofstream f(path, std::ios::trunc);
+            f << make_profile(bands);
+        }
+
+        L1Parser parser;
+        if (!parser.load(path, false)) {
+            fprintf(stderr, "cannot load %s\n", path.c_str());
+            return 1;
+        }
+        auto parsed = parser.snapshot();
+
+        // Image lookups go through L1Image directly, load() only maps L1_CACHE_PATH
+        std::unique_ptr<L1Image> image;
+        if (parsed->compile(img_path)) image = L1Image::open(img_path, path);
+
+        std::vector<std::string_view> if_keys, dev_keys;
+        for (const auto& kv : parsed->get_if_map()) if_keys.push_back(kv.first);
+        for (const auto& kv : parsed->get_all()) dev_keys.push_back(kv.first);
+
+        auto bench_set = [&](const std::vector<std::string_view>& keys, double& umap_ns, double& phf_ns, double& build_us) {
+            std::unordered_map<std::string_view, uint32_t> umap;
+            for (uint32_t i = 0; i < keys.size(); ++i) umap.emplace(keys[i], i);
+
+            utils::PerfectHash ph;
+            auto t0 = std::chrono::steady_clock::now();
+            ph.build(keys);
+            build_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            std::vector<std::string_view> slots(keys.size());
+            for (const auto& k : keys) slots[ph.slot(k)] = k;
+
+            auto probes = probes_for(keys);
+            umap_ns = ns_per_op(probes.size(), [&]() {
+                for (const auto& p : probes) {
+                    auto it = umap.find(p);
+                    sink = sink + (it != umap.end() ? it->second : 0);
+                }
+            });
+            phf_ns = ns_per_op(probes.size(), [&]() {
+                for (const auto& p : probes) {
+                    uint32_t s = ph.slot(p);
+                    sink = sink + (slots[s] == p ? s : 0);
+                }
+            });
+        };
+
+        double if_umap, if_phf, if_build, dev_umap, dev_phf, dev_build;
+        bench_set(if_keys, if_umap, if_phf, if_build);
+        bench_set(dev_keys, dev_umap, dev_phf, dev_build);
+
+        auto probes = probes_for(if_keys);
+        auto snap_ns = [&](const L1Snapshot& s) {
+            return ns_per_op(probes.size(), [&]() {
+                for (const auto& p : probes) sink = sink + s.if_prop_view(p, L1Key::nvram_zone).has_value();
+            });
+        };
+        double parsed_ns = snap_ns(*parsed);
+        double image_ns = 0;
+        if (image) {
+            image_ns = ns_per_op(probes.size(), [&]() {
+                for (const auto& p : probes) sink = sink + image->prop(image->find_if(p, L1IfLimits()), L1Key::nvram_zone).has_value();
+            });
+        }
+
+        printf("%6zu %6zu | %9.1f %9.1f | %9.1f %9.1f | %7.1f %7.1f | %8.1f\n", bands, if_keys.size(),
+               if_umap, if_phf, dev_umap, dev_phf, parsed_ns, image_ns, if_build + dev_build);
+    }
+
+    unlink(path.c_str());
+    unlink(img_path.c_str());
+    return 0;
+}
@@ -0,0 +1,270 @@
+/*
+ * End-to-end benchmark for regression tracking, reported as one JSON object.
+ *
+ * Generates a profile (see profile_gen.hpp) into a temporary file and times:
+ *   load     parse from the file, parse from a buffer, compile an image and
+ *            open it again (microseconds per call)
+ *   cpp      every L1Parser getter (ns per lookup)
+ *   c        the C wrapper, allocating, _ref and _r flavours (ns per lookup)
+ *   l1util   spawning l1util -f <profile> for one query (microseconds per
+ *            process, mean and median), null if the binary cannot be run
+ * Key lookups probe every interface / device / zone once plus 25% misses.
+ *
+ * Usage: l1bench [chipsets] [bands] [props] [seed] [l1util]
+ */
+#include "l1parser.h"
+#include "l1parser.hpp"
+#include "profile_gen.hpp"
+#include "../lib/l1image.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+extern char** environ;
+
+#ifndef L1BENCH_L1UTIL
+#define L1BENCH_L1UTIL "l1util"
+#endif
+
+using Results = std::vector<std::pair<std::string, double>>;
+
+template <typename Fn>
+static double ns_per_op(size_t ops, Fn fn) {
+    using clock = std::chrono::steady_clock;
+    size_t iters = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    do {
+        fn();
+        iters++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < 0.2);
+    return elapsed * 1e9 / (double)(iters * std::max<size_t>(ops, 1));
+}
+
+// Every key once plus 25% near misses, in a fixed shuffled order
+static std::vector<std::string> probes_for(std::vector<std::string> keys) {
+    size_t n = keys.size();
+    for (size_t i = 0; i < n / 4; ++i) keys.push_back(keys[i] + "z");
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+    return keys;
+}
+
+// Wall time of one l1util run in microseconds, negative if it did not run
+static double time_l1util(const std::string& bin, const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(bin.c_str()));
+    for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int rc = posix_spawn(&pid, bin.c_str(), &fa, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&fa);
+    if (rc != 0) return -1;
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) > 1) return -1;
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void print_section(const char* name, const Results& r, bool last = false) {
+    printf("  \"%s\": {", name);
+    for (size_t i = 0; i < r.size(); ++i) {
+        printf("%s\n    \"%s\": %.1f", i ? "," : "", r[i].first.c_str(), r[i].second);
+    }
+    printf("\n  }%s\n", last ? "" : ",");
+}
+
+int main(int argc, char* argv[]) {
+    ProfileGenOptions opt;
+    if (argc > 1) opt.chipsets = strtoul(argv[1], nullptr, 10);
+    if (argc > 2) opt.bands = strtoul(argv[2], nullptr, 10);
+    if (argc > 3) opt.props = strtoul(argv[3], nullptr, 10);
+    if (argc > 4) opt.seed = (uint32_t)strtoul(argv[4], nullptr, 10);
+    std::string l1util = argc > 5 ? argv[5] : L1BENCH_L1UTIL;
+    if (opt.chipsets == 0 || opt.bands == 0) {
+        fprintf(stderr, "Usage: l1bench [chipsets] [bands] [props] [seed] [l1util]\n");
+        return 1;
+    }
+
+    std::string text = gen_profile(opt);
+    std::string path = "/tmp/l1bench." + std::to_string(getpid()) + ".dat";
+    std::string img_path = path + ".img";
+    {
+        std::ofstream f(path, std::ios::trunc);
+        f << text;
+    }
+
+    L1Parser parser;
+    if (!parser.load(path, false)) {
+        fprintf(stderr, "cannot load %s\n", path.c_str());
+        unlink(path.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> devs = parser.list_devs();
+    std::vector<std::string> ifs, zones, dats;
+    for (const auto& kv : parser.get_if_map()) ifs.emplace_back(kv.first);
+    std::sort(ifs.begin(), ifs.end());
+    for (const auto& d : devs) {
+        if (auto z = parser.get_prop(d, "nvram_zone")) zones.push_back(*z);
+        if (auto p = parser.get_prop(d, "profile_path")) dats.push_back(*p);
+    }
+    size_t n_idx = parser.idx_table().size();
+
+    auto if_probes = probes_for(ifs);
+    auto dev_probes = probes_for(devs);
+    auto zone_probes = probes_for(zones);
+    auto dat_probes = probes_for(dats);
+    volatile size_t sink = 0;
+
+    // Loading
+    Results load;
+    load.emplace_back("parse_us", ns_per_op(1, [&]() {
+        L1Parser p;
+        sink = sink + p.load(path, false);
+    }) / 1e3);
+    load.emplace_back("buffer_us", ns_per_op(1, [&]() {
+        L1Parser p;
+        sink = sink + p.load_from_buffer(text);
+    }) / 1e3);
+    load.emplace_back("compile_us", ns_per_op(1, [&]() { sink = sink + parser.compile(img_path); }) / 1e3);
+    load.emplace_back("image_open_us", ns_per_op(1, [&]() {
+        sink = sink + (L1Image::open(img_path, path) != nullptr);
+    }) / 1e3);
+
+    // C++ getters
+    Results cpp;
+    auto each = [&](const char* name, const std::vector<std::string>& probes, auto fn) {
+        cpp.emplace_back(name, ns_per_op(probes.size(), [&]() {
+            for (const auto& p : probes) sink = sink + fn(p);
+        }));
+    };
+    each("get_prop", dev_probes, [&](const std::string& d) { return parser.get_prop(d, "profile_path").has_value(); });
+    each("get_if_prop", if_probes, [&](const std::string& i) { return parser.get_if_prop(i, "EEPROM_name").has_value(); });
+    each("if2zone", if_probes, [&](const std::string& i) { return parser.if2zone(i).has_value(); });
+    each("if2dat", if_probes, [&](const std::string& i) { return parser.if2dat(i).has_value(); });
+    each("if2dbdcidx", if_probes, [&](const std::string& i) { return parser.if2dbdcidx(i).has_value(); });
+    each("if2idx", if_probes, [&](const std::string& i) { return parser.if2idx(i).has_value(); });
+    each("zone2if", zone_probes, [&](const std::string& z) { return parser.zone2if(z).size(); });
+    each("zone2devs", zone_probes, [&](const std::string& z) { return parser.zone2devs(z).size(); });
+    each("zone2ifs", zone_probes, [&](const std::string& z) { return parser.zone2ifs(z).size(); });
+    each("dat2ifs", dat_probes, [&](const std::string& p) { return parser.dat2ifs(p).size(); });
+    each("dev2ifs", dev_probes, [&](const std::string& d) { return parser.dev2ifs(d).size(); });
+    each("query", if_probes, [&](const std::string& i) {
+        return (size_t)parser.query(std::vector<std::string_view>{ "if2zone", i }).status;
+    });
+    cpp.emplace_back("idx2if", ns_per_op(n_idx + 1, [&]() {
+        for (size_t i = 1; i <= n_idx + 1; ++i) sink = sink + parser.idx2if(i).has_value();
+    }));
+    cpp.emplace_back("list_devs", ns_per_op(1, [&]() { sink = sink + parser.list_devs().size(); }));
+    cpp.emplace_back("idx_table", ns_per_op(1, [&]() { sink = sink + parser.idx_table().size(); }));
+
+    // C wrapper
+    Results c;
+    if (L1Context* ctx = l1_init_file(path.c_str())) {
+        char buf[256];
+        auto each_c = [&](const char* name, const std::vector<std::string>& probes, auto fn) {
+            c.emplace_back(name, ns_per_op(probes.size(), [&]() {
+                for (const auto& p : probes) sink = sink + fn(p.c_str());
+            }));
+        };
+        auto owned = [](char* s) {
+            bool found = s != nullptr;
+            free(s);
+            return found;
+        };
+        auto owned_list = [](char** arr, size_t n) {
+            l1_free_str_array(arr, n);
+            return n;
+        };
+        each_c("l1_get", dev_probes, [&](const char* d) { return owned(l1_get(ctx, d, "profile_path")); });
+        each_c("l1_get_ref", dev_probes, [&](const char* d) { return l1_get_ref(ctx, d, "profile_path") != nullptr; });
+        each_c("l1_get_r", dev_probes, [&](const char* d) { return l1_get_r(ctx, d, "profile_path", buf, sizeof(buf)); });
+        each_c("l1_if2zone", if_probes, [&](const char* i) { return owned(l1_if2zone(ctx, i)); });
+        each_c("l1_if2zone_ref", if_probes, [&](const char* i) { return l1_if2zone_ref(ctx, i) != nullptr; });
+        each_c("l1_if2zone_r", if_probes, [&](const char* i) { return l1_if2zone_r(ctx, i, buf, sizeof(buf)); });
+        each_c("l1_if2dat", if_probes, [&](const char* i) { return owned(l1_if2dat(ctx, i)); });
+        each_c("l1_if2dbdcidx", if_probes, [&](const char* i) { return owned(l1_if2dbdcidx(ctx, i)); });
+        each_c("l1_if2idx", if_probes, [&](const char* i) { return l1_if2idx(ctx, i); });
+        each_c("l1_zone2if", zone_probes, [&](const char* z) {
+            size_t n = 0;
+            char** arr = l1_zone2if(ctx, z, &n);
+            return owned_list(arr, n);
+        });
+        each_c("l1_dev2ifs", dev_probes, [&](const char* d) {
+            size_t n = 0;
+            char** arr = l1_dev2ifs(ctx, d, &n);
+            return owned_list(arr, n);
+        });
+        c.emplace_back("l1_idx2if_ref", ns_per_op(n_idx + 1, [&]() {
+            for (size_t i = 1; i <= n_idx + 1; ++i) sink = sink + (l1_idx2if_ref(ctx, i) != nullptr);
+        }));
+        std::vector<std::string> lines;
+        for (const auto& i : if_probes) lines.push_back("if2zone " + i);
+        std::vector<const char*> queries;
+        for (const auto& l : lines) queries.push_back(l.c_str());
+        c.emplace_back("l1_query_batch", ns_per_op(queries.size(), [&]() {
+            char** answers = l1_query_batch(ctx, queries.data(), queries.size());
+            sink = sink + (answers != nullptr);
+            free(answers);
+        }));
+        l1_free(ctx);
+    }
+
+    // l1util processes
+    Results util;
+    bool util_ok = true;
+    auto run_util = [&](const char* name, std::vector<std::string> args) {
+        if (!util_ok) return;
+        args.insert(args.begin(), { "-f", path });
+        std::vector<double> runs;
+        double total = 0;
+        while (runs.size() < 5 || (total < 1e6 && runs.size() < 200)) {
+            double us = time_l1util(l1util, args);
+            if (us < 0) {
+                util_ok = false;
+                return;
+            }
+            runs.push_back(us);
+            total += us;
+        }
+        std::sort(runs.begin(), runs.end());
+        util.emplace_back(std::string(name) + "_mean_us", total / (double)runs.size());
+        util.emplace_back(std::string(name) + "_median_us", runs[runs.size() / 2]);
+    };
+    run_util("get", { "get", devs.front(), "profile_path" });
+    run_util("if2zone", { "if2zone", ifs.front() });
+    run_util("list", { "list" });
+    run_util("batch", { "batch", "if2zone " + ifs.front(), "idx2if 1", "list" });
+
+    printf("{\n");
+    printf("  \"profile\": {\"chipsets\": %zu, \"bands\": %zu, \"props\": %zu, \"seed\": %u, "
+           "\"bytes\": %zu, \"devices\": %zu, \"interfaces\": %zu},\n",
+           opt.chipsets, opt.bands, opt.props, opt.seed, text.size(), devs.size(), ifs.size());
+    print_section("load", load);
+    print_section("cpp_ns", cpp);
+    if (c.empty()) printf("  \"c_ns\": null,\n");
+    else print_section("c_ns", c);
+    if (!util_ok) printf("  \"l1util_us\": null\n");
+    else print_section("l1util_us", util, true);
+    printf("}\n");
+
+    unlink(path.c_str());
+    unlink(img_path.c_str());
+    return 0;
+}
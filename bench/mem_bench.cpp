@@ -0,0 +1,221 @@
+/*
+ * Memory a loaded profile costs, for regression tracking, reported as one
+ * JSON object with an entry per generated profile (see profile_gen.hpp) and
+ * layout (parsed, compact, parsed into a buffer lent with set_arena()):
+ *   heap      bytes malloc holds for a new L1Parser once load() returns, the
+ *             mallinfo2() delta (null where the libc has no mallinfo2)
+ *   usage     memory_usage().total(), the parser's own estimate
+ *   image     of which the compact image region, outside the heap
+ *   arena     bytes the snapshot's arena took, and arena_chunks the heap
+ *             chunks among them
+ *   allocs    operator new calls made by load()
+ *   frees     operator delete calls made by destroying the parser
+ *   load_us, teardown_us   median over RUNS loads
+ *
+ * Usage: l1bench-mem [chipsets] [bands] [props] [seed]
+ * Without arguments: the 2x2 and 64x4 profiles the string pool was sized on.
+ */
+#include "l1parser.hpp"
+#include "profile_gen.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <malloc.h>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#define L1BENCH_HEAP 1
+#endif
+
+// Bytes malloc hands out right now, -1 if the libc cannot tell. Large
+// blocks (an arena chunk) are mmap()ed on their own and count in hblkhd.
+static long heap_in_use() {
+#ifdef L1BENCH_HEAP
+    struct mallinfo2 mi = mallinfo2();
+    return (long)(mi.uordblks + mi.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Every operator new and delete of the process, libl1parser's included.
+ * The aligned forms matter: std::pmr resources allocate through them.
+ */
+static std::atomic<size_t> n_new{ 0 }, n_delete{ 0 };
+
+static void* counted_new(size_t n, size_t align) {
+    n_new.fetch_add(1, std::memory_order_relaxed);
+    void* p = nullptr;
+    if (posix_memalign(&p, std::max(align, sizeof(void*)), n ? n : 1) != 0) return nullptr;
+    return p;
+}
+
+static void counted_delete(void* p) {
+    if (!p) return;
+    n_delete.fetch_add(1, std::memory_order_relaxed);
+    free(p);
+}
+
+void* operator new(size_t n) {
+    if (void* p = counted_new(n, alignof(std::max_align_t))) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void* operator new(size_t n, std::align_val_t a) {
+    if (void* p = counted_new(n, (size_t)a)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n, std::align_val_t a) { return operator new(n, a); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return counted_new(n, alignof(std::max_align_t)); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return counted_new(n, alignof(std::max_align_t)); }
+void operator delete(void* p) noexcept { counted_delete(p); }
+void operator delete[](void* p) noexcept { counted_delete(p); }
+void operator delete(void* p, size_t) noexcept { counted_delete(p); }
+void operator delete[](void* p, size_t) noexcept { counted_delete(p); }
+void operator delete(void* p, std::align_val_t) noexcept { counted_delete(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_delete(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { counted_delete(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { counted_delete(p); }
+
+struct Layout {
+    const char* name;
+    bool compact;
+    bool arena;     // lend a buffer big enough for the whole snapshot
+};
+
+static const Layout LAYOUTS[] = {
+    { "parsed", false, false },
+    { "compact", true, false },
+    { "lent", false, true },
+};
+static const size_t N_LAYOUTS = sizeof(LAYOUTS) / sizeof(LAYOUTS[0]);
+
+static const size_t RUNS = 15;
+
+struct Sample {
+    long heap = -1;
+    L1MemUsage mem;
+    size_t devs = 0;
+    size_t allocs = 0, frees = 0;
+    double load_us = 0, teardown_us = 0;
+};
+
+static double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+static bool sample(const std::string& path, size_t text_size, const Layout& layout, Sample& s) {
+    using clock = std::chrono::steady_clock;
+    auto us = [](clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+    // Generous: a parsed snapshot takes a few times the text
+    std::vector<char> buf(layout.arena ? text_size * 16 + 65536 : 0);
+    std::vector<double> load_us, teardown_us;
+    for (size_t run = 0; run < RUNS; ++run) {
+        long before = heap_in_use();
+        auto* parser = new L1Parser();
+        parser->set_compact(layout.compact);
+        if (layout.arena) parser->set_arena(buf.data(), buf.size());
+
+        size_t news = n_new.load();
+        auto start = clock::now();
+        bool ok = parser->load(path, false);
+        load_us.push_back(us(clock::now() - start));
+        s.allocs = n_new.load() - news;
+        if (!ok) {
+            delete parser;
+            return false;
+        }
+        if (run == 0) {
+            if (before >= 0) s.heap = heap_in_use() - before;
+            s.mem = parser->memory_usage();
+            s.devs = parser->list_devs().size();
+        }
+
+        size_t deletes = n_delete.load();
+        start = clock::now();
+        delete parser;
+        teardown_us.push_back(us(clock::now() - start));
+        s.frees = n_delete.load() - deletes;
+    }
+    s.load_us = median(load_us);
+    s.teardown_us = median(teardown_us);
+    return true;
+}
+
+static bool measure(const ProfileGenOptions& opt, const std::string& path, bool last) {
+    std::string text = gen_profile(opt);
+    {
+        std::ofstream f(path, std::ios::trunc);
+        f << text;
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", path.c_str());
+            return false;
+        }
+    }
+
+    Sample samples[N_LAYOUTS];
+    for (size_t i = 0; i < N_LAYOUTS; ++i) {
+        if (!sample(path, text.size(), LAYOUTS[i], samples[i])) {
+            fprintf(stderr, "cannot load %s\n", path.c_str());
+            return false;
+        }
+    }
+
+    printf("    {\"chipsets\": %zu, \"bands\": %zu, \"props\": %zu, \"seed\": %u, \"bytes\": %zu, \"devices\": %zu",
+           opt.chipsets, opt.bands, opt.props, opt.seed, text.size(), samples[0].devs);
+    for (size_t i = 0; i < N_LAYOUTS; ++i) {
+        const Sample& s = samples[i];
+        printf(",\n     \"%s\": {\"heap\": ", LAYOUTS[i].name);
+        if (s.heap < 0) printf("null");
+        else printf("%ld", s.heap);
+        printf(", \"usage\": %zu, \"image\": %zu, \"arena\": %zu, \"arena_chunks\": %zu,\n       ",
+               (size_t)s.mem.total(), (size_t)s.mem.image, (size_t)s.mem.arena, (size_t)s.mem.arena_chunks);
+        printf("\"allocs\": %zu, \"frees\": %zu, \"load_us\": %.1f, \"teardown_us\": %.1f}",
+               s.allocs, s.frees, s.load_us, s.teardown_us);
+    }
+    printf("}%s\n", last ? "" : ",");
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<ProfileGenOptions> profiles;
+    if (argc > 1) {
+        ProfileGenOptions opt;
+        opt.chipsets = strtoul(argv[1], nullptr, 10);
+        if (argc > 2) opt.bands = strtoul(argv[2], nullptr, 10);
+        if (argc > 3) opt.props = strtoul(argv[3], nullptr, 10);
+        if (argc > 4) opt.seed = (uint32_t)strtoul(argv[4], nullptr, 10);
+        if (argc > 5 || opt.chipsets == 0 || opt.bands == 0) {
+            fprintf(stderr, "Usage: l1bench-mem [chipsets] [bands] [props] [seed]\n");
+            return 1;
+        }
+        profiles.push_back(opt);
+    } else {
+        ProfileGenOptions small, large;
+        small.chipsets = 2;
+        small.bands = 2;
+        large.chipsets = 64;
+        large.bands = 4;
+        profiles = { small, large };
+    }
+
+    std::string path = "/tmp/l1bench-mem." + std::to_string(getpid()) + ".dat";
+    printf("{\n  \"profiles\": [\n");
+    bool ok = true;
+    for (size_t i = 0; i < profiles.size() && ok; ++i) {
+        ok = measure(profiles[i], path, i + 1 == profiles.size());
+    }
+    printf("  ]\n}\n");
+    unlink(path.c_str());
+    return ok ? 0 : 1;
+}
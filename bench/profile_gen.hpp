@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+ * Synthetic l1profile generator shared by the benchmarks and l1gen-profile.
+ *
+ * Blocks cycle through real chipset names (so main_idx counts up per
+ * chipset), every band gets its own interface letters (ra0/rax0/rai0...) and
+ * zone, and the virtual interface prefixes vary the way vendor profiles do:
+ * some blocks leave ext/apcli out, use "ra0_" style stems or only declare
+ * wds/mesh on some bands. The same seed always gives the same text.
+ */
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+struct ProfileGenOptions {
+    size_t chipsets = 4;    // INDEX blocks
+    size_t bands = 2;       // bands per block
+    size_t props = 8;       // extra per-band properties per block
+    uint32_t seed = 1;
+};
+
+// "", "x", "i", "e", ... then two letters; unique interface letters per band
+inline std::string gen_band_letters(size_t n) {
+    static const char* first[] = { "", "x", "i", "e", "y", "z", "u", "v", "w", "t", "s", "q" };
+    const size_t nfirst = sizeof(first) / sizeof(first[0]);
+    if (n < nfirst) return first[n];
+    n -= nfirst;
+    std::string out;
+    out += (char)('a' + n / 26 % 26);
+    out += (char)('a' + n % 26);
+    if (n >= 26 * 26) out += std::to_string(n / (26 * 26));
+    return out;
+}
+
+inline std::string gen_profile(const ProfileGenOptions& opt) {
+    static const char* chips[] = { "MT7981", "MT7986", "MT7916", "MT7996", "MT7915", "MT7992" };
+    std::mt19937 rng(opt.seed);
+    auto chance = [&](unsigned percent) { return rng() % 100 < percent; };
+
+    std::string out = "Default\n";
+    size_t band_no = 0;
+    for (size_t c = 0; c < opt.chipsets; ++c) {
+        std::string idx = "INDEX" + std::to_string(c);
+        std::string chip = chips[c % (sizeof(chips) / sizeof(chips[0]))];
+        std::string lower = "mt" + chip.substr(2);
+
+        std::string main, ext, apcli, wds, mesh, zone, dat, sku;
+        bool has_ext = chance(85), has_apcli = chance(75), has_wds = chance(40), has_mesh = chance(30);
+        bool stem_digits = chance(20);
+        for (size_t b = 0; b < opt.bands; ++b, ++band_no) {
+            std::string l = gen_band_letters(band_no);
+            std::string sep = b ? ";" : "";
+            main += sep + "ra" + l + "0";
+            ext += sep + (stem_digits ? "ra" + l + "0_" : "ra" + l);
+            apcli += sep + "apcli" + l;
+            // Only some bands carry wds/mesh, the rest stay empty
+            wds += sep + (b % 2 == 0 ? "wds" + l : "");
+            mesh += sep + (b == 0 ? "mesh" + l : "");
+            zone += sep + "dev" + std::to_string(band_no + 1);
+            dat += sep + "/etc/wireless/mediatek/" + lower + ".dbdc.b" + std::to_string(b) + ".dat";
+            sku += sep + "/etc/wireless/mediatek/" + lower + "-sku.dat";
+        }
+
+        out += idx + "=" + chip + "\n";
+        out += idx + "_profile_path=" + dat + "\n";
+        out += idx + "_init_compatible=" + lower + "\n";
+        out += idx + "_EEPROM_offset=0x" + std::to_string(c) + "000\n";
+        out += idx + "_EEPROM_size=0x1000\n";
+        out += idx + "_EEPROM_name=e2p\n";
+        out += idx + "_main_ifname=" + main + "\n";
+        if (has_ext) out += idx + "_ext_ifname=" + ext + "\n";
+        if (has_apcli) out += idx + "_apcli_ifname=" + apcli + "\n";
+        if (has_wds) out += idx + "_wds_ifname=" + wds + "\n";
+        if (has_mesh) out += idx + "_mesh_ifname=" + mesh + "\n";
+        // Hand-edited files: spacing around '=' and trailing comments
+        out += chance(20) ? idx + "_nvram_zone = " + zone + "  # zones\n" : idx + "_nvram_zone=" + zone + "\n";
+        out += idx + "_single_sku_path=" + sku + "\n";
+        for (size_t p = 0; p < opt.props; ++p) {
+            std::string v;
+            for (size_t b = 0; b < opt.bands; ++b) v += (b ? ";" : "") + std::to_string(rng() % 100000);
+            out += idx + "_prop" + std::to_string(p) + "=" + v + "\n";
+        }
+    }
+    return out;
+}
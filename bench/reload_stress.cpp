@@ -0,0 +1,228 @@
+/*
+ * Concurrent reader / reloader stress run for snapshot publication.
+ *
+ * Writes a profile whose values all carry a generation number, then keeps
+ * rewriting it (new generation, and a varying number of blocks) while reader
+ * threads hammer lookups. Every snapshot must be internally consistent: all
+ * values of one snapshot share a generation, and that generation never goes
+ * backwards for a given reader. Half the reloads are explicit reload() calls,
+ * the others come from the inotify watcher.
+ *
+ * Before that, reloads of a profile rewritten with the same text must keep
+ * the published snapshot: parsed, compact, and opened from the compiled
+ * image. The image part needs to write L1_CACHE_PATH and is skipped when
+ * that file already exists, an image in use is never replaced.
+ *
+ * Exits non-zero on the first inconsistency.
+ *
+ * Usage: l1bench-reload [seconds] [readers] [dir]
+ */
+#include "l1parser.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string make_profile(unsigned gen, size_t blocks) {
+    std::string g = std::to_string(gen);
+    std::string out = "Default\n";
+    for (size_t b = 1; b <= blocks; ++b) {
+        std::string idx = "INDEX" + std::to_string(b);
+        std::string n = std::to_string(b);
+        out += idx + "=MT7996\n";
+        out += idx + "_main_ifname=ra" + n + ";rai" + n + "\n";
+        out += idx + "_ext_ifname=ra" + n + "_;rai" + n + "_\n";
+        out += idx + "_nvram_zone=zone" + n + "a;zone" + n + "b\n";
+        out += idx + "_profile_path=/gen" + g + "/a" + n + ".dat;/gen" + g + "/b" + n + ".dat\n";
+        out += idx + "_gen=" + g + ";" + g + "\n";
+    }
+    return out;
+}
+
+// Atomic replace, like any well-behaved config writer
+static bool write_profile(const std::string& path, unsigned gen, size_t blocks) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        f << make_profile(gen, blocks);
+        if (!f) return false;
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static std::atomic<bool> failed{ false };
+
+static void fail(const std::string& msg) {
+    if (!failed.exchange(true)) fprintf(stderr, "FAIL: %s\n", msg.c_str());
+}
+
+// Check one snapshot end to end, returns its generation
+static long check_snapshot(const L1Snapshot& snap) {
+    auto devs = snap.list_devs();
+    if (devs.empty() || devs.size() % 2) {
+        fail("odd device count " + std::to_string(devs.size()));
+        return -1;
+    }
+
+    long gen = -1;
+    for (const auto& dev : devs) {
+        auto g = snap.get_prop(dev, "gen");
+        if (!g) {
+            fail("missing gen on " + dev);
+            return -1;
+        }
+        long v = strtol(g->c_str(), nullptr, 10);
+        if (gen < 0) gen = v;
+        if (v != gen) {
+            fail("mixed generations " + std::to_string(gen) + "/" + std::to_string(v));
+            return -1;
+        }
+    }
+
+    // Cross-check the interface and sequence tables against the same generation
+    std::string prefix = "/gen" + std::to_string(gen) + "/";
+    for (size_t b = 1; b <= devs.size() / 2; ++b) {
+        auto dat = snap.if2dat("rai" + std::to_string(b) + "_1");
+        if (!dat || dat->compare(0, prefix.size(), prefix) != 0) {
+            fail("if2dat out of generation " + std::to_string(gen));
+            return -1;
+        }
+    }
+    if (snap.idx2if(devs.size()) != "rai" + std::to_string(devs.size() / 2)) {
+        fail("idx2if disagrees with device list");
+        return -1;
+    }
+    return gen;
+}
+
+// The snapshot stays across a reload of the same text; rewrite first or not
+static bool keeps_snapshot(L1Parser& parser, const std::string& path, bool rewrite, const char* what) {
+    auto before = parser.snapshot();
+    L1Diff diff;
+    if ((rewrite && !write_profile(path, 0, 4)) || !parser.reload(&diff)) {
+        fail(std::string(what) + ": reload failed");
+        return false;
+    }
+    if (parser.snapshot() != before || !diff.empty()) {
+        fail(std::string(what) + ": unchanged profile published a new snapshot");
+        return false;
+    }
+    return true;
+}
+
+// Returns whether the image was checked too
+static bool check_unchanged(const std::string& path) {
+    L1Parser parsed, compact;
+    compact.set_compact(true);
+    if (!parsed.load(path, false) || !compact.load(path, false)) {
+        fail("cannot load " + path);
+        return false;
+    }
+    if (!keeps_snapshot(parsed, path, true, "parsed") || !keeps_snapshot(compact, path, true, "compact")) return false;
+
+    // And a real change still gets through
+    auto before = parsed.snapshot();
+    if (!write_profile(path, 1, 4) || !parsed.reload() || parsed.snapshot() == before) {
+        fail("changed profile kept its snapshot");
+        return false;
+    }
+    if (!write_profile(path, 0, 4)) return false;
+
+    struct stat st;
+    if (stat(L1_CACHE_PATH, &st) == 0 || errno != ENOENT) return false;
+    auto compile = [&]() {
+        L1Parser source;
+        return source.load(path, false) && source.compile(L1_CACHE_PATH);
+    };
+    if (!compile()) return false;
+    L1Parser imaged;
+    if (!imaged.load(path, true) || !imaged.from_image()) {
+        fail("compiled image not used");
+    } else if (keeps_snapshot(imaged, path, true, "stale image") && compile()) {
+        // The image matches the file again, the reload opens it
+        keeps_snapshot(imaged, path, false, "image");
+    }
+    unlink(L1_CACHE_PATH);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? strtod(argv[1], nullptr) : 3.0;
+    unsigned nreaders = argc > 2 ? (unsigned)strtoul(argv[2], nullptr, 10) : 4;
+    std::string dir = argc > 3 ? argv[3] : "/tmp";
+    std::string path = dir + "/l1bench-reload." + std::to_string(getpid()) + ".dat";
+
+    if (!write_profile(path, 0, 4)) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+    }
+    bool image_checked = check_unchanged(path);
+    if (failed) {
+        unlink(path.c_str());
+        return 1;
+    }
+    printf("unchanged reloads kept their snapshot (image %s)\n", image_checked ? "checked" : "skipped");
+
+    L1Parser parser;
+    if (!parser.load(path, false) || !parser.watch()) {
+        fprintf(stderr, "cannot load/watch %s\n", path.c_str());
+        unlink(path.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> stop{ false };
+    std::vector<unsigned long> lookups(nreaders, 0);
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < nreaders; ++r) {
+        readers.emplace_back([&, r]() {
+            long last = -1;
+            while (!stop.load(std::memory_order_relaxed) && !failed.load(std::memory_order_relaxed)) {
+                // Pinned snapshot: a full consistency check
+                long gen = check_snapshot(*parser.snapshot());
+                if (gen < last) fail("generation went backwards");
+                last = gen;
+
+                // Single lookups through the parser: each one sees some whole snapshot
+                auto dat = parser.if2dat("ra1");
+                if (!dat || dat->compare(0, 4, "/gen") != 0) fail("if2dat through parser");
+                lookups[r] += 2;
+            }
+        });
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    unsigned gen = 0;
+    unsigned explicit_reloads = 0;
+    while (!failed && std::chrono::duration<double>(clock::now() - start).count() < seconds) {
+        ++gen;
+        if (!write_profile(path, gen, 1 + gen % 8)) {
+            fail("rewrite failed");
+            break;
+        }
+        if (gen % 2) {
+            if (!parser.reload()) fail("reload failed");
+            explicit_reloads++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(gen % 2 ? 1 : 60));
+    }
+
+    stop = true;
+    for (auto& t : readers) t.join();
+    parser.unwatch();
+    unlink(path.c_str());
+
+    unsigned long total = 0;
+    for (auto n : lookups) total += n;
+    printf("%u generations (%u explicit reloads), %u readers, %lu lookups, final gen seen %ld\n",
+           gen, explicit_reloads, nreaders, total, failed ? -1L : check_snapshot(*parser.snapshot()));
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Throughput benchmark for the profile tokenizer.
+ *
+ * Builds a synthetic l1profile with many INDEX blocks and long per-band
+ * values, then reports MB/s for each scanner implementation the CPU supports:
+ * the raw line/comment scan, the ';' split scan, and a complete load.
+ *
+ * Usage: l1bench-scan [blocks] [bands] [props]
+ */
+#include "l1parser.hpp"
+#include "../utils/scan.hpp"
+#include "../utils/stringutils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static std::string make_profile(size_t blocks, size_t bands, size_t props) {
+    std::string out = "Default\n";
+    for (size_t b = 0; b < blocks; ++b) {
+        std::string idx = "INDEX" + std::to_string(b);
+        out += idx + "=MT7996\n";
+        auto joined = [&](const std::string& stem) {
+            std::string v;
+            for (size_t i = 0; i < bands; ++i) {
+                if (i) v += ";";
+                v += stem + std::to_string(b) + "_" + std::to_string(i);
+            }
+            return v;
+        };
+        out += idx + "_main_ifname=" + joined("ra") + "\n";
+        out += idx + "_nvram_zone=" + joined("dev") + "\n";
+        out += idx + "_profile_path=" + joined("/etc/wireless/mediatek/mt7996.b") + "\n";
+        out += idx + "_EEPROM_name=e2p # inline comment\n";
+        for (size_t p = 0; p < props; ++p) {
+            out += idx + "_prop" + std::to_string(p) + "=" + joined("some_long_band_value_") + "\n";
+        }
+    }
+    return out;
+}
+
+template <typename Fn>
+static double mb_per_sec(size_t bytes, Fn fn) {
+    using clock = std::chrono::steady_clock;
+    size_t iters = 0;
+    auto start = clock::now();
+    double elapsed = 0;
+    do {
+        fn();
+        iters++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < 0.5);
+    return (double)bytes * (double)iters / elapsed / (1024.0 * 1024.0);
+}
+
+int main(int argc, char* argv[]) {
+    size_t blocks = argc > 1 ? strtoul(argv[1], nullptr, 10) : 512;
+    size_t bands = argc > 2 ? strtoul(argv[2], nullptr, 10) : 4;
+    size_t props = argc > 3 ? strtoul(argv[3], nullptr, 10) : 16;
+
+    std::string profile = make_profile(blocks, bands, props);
+    std::string_view buf = profile;
+    printf("profile: %zu blocks, %zu bands, %zu props, %zu bytes\n", blocks, bands, props, profile.size());
+
+    volatile size_t sink = 0;
+    for (auto impl : { utils::ScanImpl::Scalar, utils::ScanImpl::SSE2, utils::ScanImpl::AVX2 }) {
+        if (!utils::set_scan_impl(impl)) continue;
+
+        double lines = mb_per_sec(buf.size(), [&]() {
+            size_t n = 0;
+            for (size_t pos = utils::scan_for(buf, 0, '\n', '#'); pos != std::string_view::npos;
+                 pos = utils::scan_for(buf, pos + 1, '\n', '#')) {
+                n++;
+            }
+            sink = sink + n;
+        });
+        double split = mb_per_sec(buf.size(), [&]() {
+            sink = sink + utils::split(buf, ';', true).size();
+        });
+        double load = mb_per_sec(buf.size(), [&]() {
+            L1Parser p;
+            p.load_from_buffer(buf);
+            sink = sink + p.list_devs().size();
+        });
+
+        printf("%-6s  lines %8.1f MB/s  split %8.1f MB/s  load %8.1f MB/s\n",
+               utils::scan_impl_name(impl), lines, split, load);
+    }
+    return 0;
+}
@@ -2,79 +2,396 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 void usage() {
-    std::cerr << "Usage: l1util list | get <dev> <prop> | idx2if <idx> | if2zone <ifname> | if2dat <ifname> | zone2if <zone> | if2dbdcidx <ifname>" << std::endl;
+    std::cerr << "Usage: l1util [-f profile] [--profile] [--mem] [--compact] list | get <dev> <prop> | idx2if <idx> | idxtable | if2idx <ifname> | if2zone <ifname> | if2dat <ifname> | datget <ifname> <key> | zone2if <zone> | zone2devs <zone> | zone2ifs <zone> | dat2ifs <path> | dev2ifs <dev> | if2dbdcidx <ifname> | getif <ifname> <prop> | export [--format=shell|json|kv] | set <dev> <prop> <value>... | datset <ifname> <key> <value>... | compile [output] | batch [command...] | serve [socket]" << std::endl;
     exit(1);
 }
 
-void print_vector(const std::vector<std::string>& vec) {
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << (i == vec.size() - 1 ? "" : " ");
+static volatile sig_atomic_t stop_server = 0;
+
+static void on_signal(int) {
+    stop_server = 1;
+}
+
+/*
+ * Answers commands through a running daemon when there is one. Falls back to
+ * a locally loaded profile when no daemon answers, when it goes away, or for
+ * arguments the line protocol cannot carry. A profile other than L1_DAT_PATH
+ * is always parsed locally: the daemon and the image both describe the default.
+ * So is everything when profiling or measuring memory, the daemon's work
+ * and memory would not be counted.
+ * A single command on another profile is answered by scanning its text
+ * (L1Parser::query_file()), the one value asked for does not pay for a
+ * whole snapshot; commands the scan does not cover load the profile.
+ */
+class Resolver {
+public:
+    Resolver(const std::string& path, bool local_only, bool compact)
+        : path_(path), is_default_(path == L1_DAT_PATH), local_only_(local_only) {
+        parser_.set_compact(compact);
     }
-    std::cout << std::endl;
+
+    L1Reply query(const std::vector<std::string_view>& args) {
+        if (auto* client = daemon()) {
+            if (auto line = L1Client::encode(args)) {
+                if (auto reply = client->query(*line)) return *reply;
+                client_.reset();
+            }
+        }
+        // The default profile has its image, refreshed by local() when stale
+        if (!loaded_ && !is_default_ && !local_only_) {
+            if (auto reply = L1Parser::query_file(path_, args)) return *reply;
+        }
+        return local().query(args);
+    }
+
+    L1Reply query(std::string_view line) {
+        auto* client = daemon();
+        if (client && line.find('\n') == std::string_view::npos) {
+            if (auto reply = client->query(line)) return *reply;
+            client_.reset();
+        }
+        return local().query(line);
+    }
+
+    std::vector<L1Reply> query(const std::vector<std::string>& lines) {
+        if (auto* client = daemon()) {
+            bool ok = true;
+            for (const auto& line : lines) ok = ok && line.find('\n') == std::string::npos;
+            if (ok) {
+                if (auto replies = client->query(lines)) return *replies;
+            }
+            client_.reset();
+        }
+        std::vector<L1Reply> replies;
+        for (const auto& line : lines) replies.push_back(local().query(std::string_view(line)));
+        return replies;
+    }
+
+    L1Parser& local() {
+        if (!loaded_) {
+            if (!parser_.load(path_, is_default_)) {
+                std::cerr << "Error: Failed to load profile: " << path_ << std::endl;
+                exit(1);
+            }
+            // Image was missing or stale, refresh it for the next invocation
+            if (is_default_ && !parser_.from_image()) parser_.compile(L1_CACHE_PATH);
+            loaded_ = true;
+        }
+        return parser_;
+    }
+
+private:
+    // Connected on the first query: export and write-back never ask the
+    // daemon, they should not wait for it either
+    L1Client* daemon() {
+        if (!connected_) {
+            connected_ = true;
+            if (is_default_ && !local_only_) client_ = L1Client::connect();
+        }
+        return client_.get();
+    }
+
+    std::string path_;
+    bool is_default_;
+    bool local_only_;
+    bool connected_ = false;    // connect attempted
+    std::unique_ptr<L1Client> client_;
+    L1Parser parser_;
+    bool loaded_ = false;
+};
+
+// --profile: counters of this run on stderr, the answer stays alone on stdout
+void print_stats(const L1Parser& parser) {
+    L1Stats stats = parser.stats();
+    if (!stats.enabled) std::cerr << "Warning: l1parser was built without ENABLE_STATS" << std::endl;
+    std::cerr << l1_stats_json(stats) << std::endl;
 }
 
-void print_result(std::optional<std::string> res) {
-    if (res.has_value()) {
-        std::cout << res.value() << std::endl;
-    } else {
-        exit(1);
+// --mem: bytes the loaded profile holds per structure, on stderr as well
+void print_mem(const L1Parser& parser) {
+    std::cerr << l1_mem_json(parser.memory_usage()) << std::endl;
+}
+
+// Batch output, one line per command: "OK <value>", "NONE" or "ERR [reason]"
+void print_reply(const L1Reply& reply) {
+    std::cout << reply.to_line() << '\n';
+}
+
+// Answer each argument as one command, or read commands from stdin line by line
+void run_batch(Resolver& resolver, const std::vector<std::string>& args) {
+    std::ios::sync_with_stdio(false);
+
+    if (args.size() > 1) {
+        // Arguments are known up front, pipeline them in one round trip
+        std::vector<std::string> lines(args.begin() + 1, args.end());
+        for (const auto& reply : resolver.query(lines)) print_reply(reply);
+        std::cout.flush();
+        return;
     }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        print_reply(resolver.query(std::string_view(line)));
+        // Flush once the pending input is drained so coprocess callers see replies
+        if (std::cin.rdbuf()->in_avail() <= 0) std::cout.flush();
+    }
+    std::cout.flush();
 }
 
-int main(int argc, char* argv[]) {
-    L1Parser parser;
-    if (!parser.load(L1_DAT_PATH)) {
-        std::cerr << "Error: Failed to load profile: " << L1_DAT_PATH << std::endl;
+struct ServerClient {
+    int fd;
+    bool eof;           // peer finished sending, close once out is flushed
+    std::string in;
+    std::string out;
+};
+
+// Requests beyond this without a newline, or replies the peer is not
+// reading, drop the connection instead of growing without bound
+static const size_t MAX_CLIENT_BUFFER = 1 << 20;
+
+// Serve queries on a Unix socket until SIGINT/SIGTERM
+int run_server(const L1Parser& parser, const std::string& path) {
+    // Refuse to steal the socket from a live daemon, but clean up a stale one
+    if (L1Client::connect(path)) {
+        std::cerr << "Error: A daemon is already listening on " << path << std::endl;
         return 1;
     }
+    unlink(path.c_str());
+
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path too long: " << path << std::endl;
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (lfd < 0 || bind(lfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(lfd, 16) != 0) {
+        std::cerr << "Error: Failed to listen on " << path << ": " << strerror(errno) << std::endl;
+        if (lfd >= 0) close(lfd);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    std::vector<ServerClient> clients;
+    std::vector<struct pollfd> pfds;
+
+    while (!stop_server) {
+        pfds.clear();
+        pfds.push_back({ lfd, POLLIN, 0 });
+        for (const auto& c : clients) {
+            short events = (!c.eof && c.out.size() < MAX_CLIENT_BUFFER) ? POLLIN : 0;
+            if (!c.out.empty()) events |= POLLOUT;
+            pfds.push_back({ c.fd, events, 0 });
+        }
+
+        if (poll(pfds.data(), pfds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Handle existing clients first, accepting below appends to clients
+        for (size_t i = 0; i < clients.size(); ++i) {
+            ServerClient& c = clients[i];
+            short rev = pfds[i + 1].revents;
+            bool drop = false;
+
+            if (!c.eof && (rev & (POLLIN | POLLHUP | POLLERR))) {
+                char buf[4096];
+                ssize_t n = read(c.fd, buf, sizeof(buf));
+                if (n > 0) {
+                    c.in.append(buf, (size_t)n);
+                    // Pipelined requests: answer every complete line, in order
+                    size_t start = 0, nl;
+                    while ((nl = c.in.find('\n', start)) != std::string::npos) {
+                        c.out += parser.query(std::string_view(c.in).substr(start, nl - start)).to_line();
+                        c.out += '\n';
+                        start = nl + 1;
+                    }
+                    c.in.erase(0, start);
+                    if (c.in.size() > MAX_CLIENT_BUFFER) drop = true;
+                } else if (n == 0) {
+                    c.eof = true;
+                } else if (errno != EINTR && errno != EAGAIN) {
+                    drop = true;
+                }
+            }
+
+            if (!drop && !c.out.empty()) {
+                ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (n > 0) c.out.erase(0, (size_t)n);
+                else if (n < 0 && errno != EAGAIN && errno != EINTR) drop = true;
+            }
+            if (c.eof && c.out.empty()) drop = true;
+
+            if (drop) {
+                close(c.fd);
+                c.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const ServerClient& c) { return c.fd < 0; }),
+                      clients.end());
+
+        if (pfds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                clients.push_back({ fd, false, "", "" });
+            }
+        }
+    }
 
+    for (const auto& c : clients) close(c.fd);
+    close(lfd);
+    unlink(path.c_str());
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     std::vector<std::string> args;
     for (int i = 1; i < argc; ++i) {
         args.emplace_back(argv[i]);
     }
 
+    std::string path = L1_DAT_PATH;
+    bool profile = false, mem = false, compact = false;
+    while (!args.empty() && (args[0] == "-f" || args[0] == "--profile" || args[0] == "--mem" || args[0] == "--compact")) {
+        if (args[0] != "-f") {
+            if (args[0] == "--profile") profile = true;
+            else if (args[0] == "--mem") mem = true;
+            else compact = true;
+            args.erase(args.begin());
+            continue;
+        }
+        if (args.size() < 2) usage();
+        path = args[1];
+        args.erase(args.begin(), args.begin() + 2);
+    }
+
     if (args.empty()) usage();
 
     const std::string& cmd = args[0];
+    auto report = [&](const L1Parser& parser) {
+        if (profile) print_stats(parser);
+        if (mem) print_mem(parser);
+    };
 
-    if (cmd == "list") {
-        print_vector(parser.list_devs());
-    }
-    else if (cmd == "get") {
-        if (args.size() != 3) usage();
-        print_result(parser.get_prop(args[1], args[2]));
-    }
-    else if (cmd == "if2zone") {
-        if (args.size() != 2) usage();
-        print_result(parser.if2zone(args[1]));
-    }
-    else if (cmd == "if2dat") {
-        if (args.size() != 2) usage();
-        print_result(parser.if2dat(args[1]));
+    if (cmd == "compile") {
+        L1Parser parser;
+        if (args.size() > 2) usage();
+        // L1_CACHE_PATH is the image of the default profile only
+        if (args.size() < 2 && path != L1_DAT_PATH) usage();
+        // Always parse the source, never an existing image
+        if (!parser.load(path, false)) {
+            std::cerr << "Error: Failed to load profile: " << path << std::endl;
+            return 1;
+        }
+        std::string out = (args.size() == 2) ? args[1] : L1_CACHE_PATH;
+        if (!parser.compile(out)) {
+            std::cerr << "Error: Failed to write image: " << out << std::endl;
+            return 1;
+        }
+        report(parser);
+        return 0;
     }
-    else if (cmd == "zone2if") {
-        if (args.size() != 2) usage();
-        print_vector(parser.zone2if(args[1]));
+
+    if (cmd == "serve") {
+        L1Parser parser;
+        if (args.size() > 2) usage();
+        // Clients of L1_SOCK_PATH expect the default profile behind it
+        if (args.size() < 2 && path != L1_DAT_PATH) usage();
+        parser.set_compact(compact);
+        if (!parser.load(path, path == L1_DAT_PATH)) {
+            std::cerr << "Error: Failed to load profile: " << path << std::endl;
+            return 1;
+        }
+        // Pick up profile edits without restarting the daemon
+        if (!parser.watch()) {
+            std::cerr << "Warning: Cannot watch " << path << ", edits need a restart" << std::endl;
+        }
+        int rc = run_server(parser, (args.size() == 2) ? args[1] : L1_SOCK_PATH);
+        report(parser);
+        return rc;
     }
-    else if (cmd == "if2dbdcidx") {
-        if (args.size() != 2) usage();
-        print_result(parser.if2dbdcidx(args[1]));
+
+    Resolver resolver(path, profile || mem, compact);
+
+    if (cmd == "export") {
+        // Multi-line output, always answered from a local snapshot
+        L1ExportFormat format = L1ExportFormat::Shell;
+        if (args.size() > 2) usage();
+        if (args.size() == 2) {
+            if (args[1] == "--format=shell") format = L1ExportFormat::Shell;
+            else if (args[1] == "--format=json") format = L1ExportFormat::Json;
+            else if (args[1] == "--format=kv") format = L1ExportFormat::Kv;
+            else usage();
+        }
+        if (!resolver.local().export_to(STDOUT_FILENO, format)) {
+            if (errno == EEXIST) {
+                std::cerr << "Error: Names map to the same shell variable, use --format=json or --format=kv" << std::endl;
+            } else {
+                std::cerr << "Error: Failed to write export: " << strerror(errno) << std::endl;
+            }
+            return 1;
+        }
+        report(resolver.local());
+        return 0;
     }
-    else if (cmd == "idx2if") {
-        if (args.size() != 2) usage();
-        try {
-            int idx = std::stoi(args[1]);
-            print_result(parser.idx2if(idx));
-        } catch (...) {
-            std::cerr << "Error: Invalid index number" << std::endl;
+
+    if (cmd == "set" || cmd == "datset") {
+        // Any number of <dev|ifname> <key> <value> triples, one rewrite per file
+        if (args.size() < 4 || (args.size() - 1) % 3 != 0) usage();
+        L1Parser& parser = resolver.local();
+        for (size_t i = 1; i < args.size(); i += 3) {
+            bool ok = (cmd == "set") ? parser.set_prop(args[i], args[i + 1], args[i + 2])
+                                     : parser.set_dat(args[i], args[i + 1], args[i + 2]);
+            if (!ok) {
+                std::cerr << "Error: Cannot set " << args[i + 1] << " of " << args[i] << std::endl;
+                return 1;
+            }
+        }
+        if (!parser.commit()) {
+            std::cerr << "Error: Failed to write back: " << strerror(errno) << std::endl;
             return 1;
         }
+        report(parser);
+        return 0;
+    }
+
+    if (cmd == "batch") {
+        run_batch(resolver, args);
+        if (profile || mem) report(resolver.local());
+        return 0;
     }
-    else {
-        usage();
+
+    L1Reply reply = resolver.query(std::vector<std::string_view>(args.begin(), args.end()));
+    if (profile || mem) report(resolver.local());
+    switch (reply.status) {
+    case L1Status::Ok:
+        std::cout << reply.value << std::endl;
+        break;
+    case L1Status::NotFound:
+        return 1;
+    case L1Status::BadRequest:
+        if (reply.value.empty()) usage();
+        std::cerr << "Error: " << reply.value << std::endl;
+        return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "l1schema.hpp"
+
+/*
+ * Virtual interface naming. Each band owns its main interface plus numbered
+ * virtual interfaces built from per-band prefixes (ext_ifname + 1..ext-1,
+ * apcli_ifname + 0..apcli-1, ...). Profiles do not list every possible name;
+ * they keep one rule per (stem, band), where the stem is the main name or the
+ * prefix, and resolve a name against the rules on lookup, so the limits can
+ * change without touching the tables.
+ *
+ * Rules are grouped by base, the stem without its trailing digits ("ra0" and
+ * "ra" both have base "ra"). Any name a rule stands for shares the rule's
+ * base, so a single base lookup finds every candidate.
+ */
+
+// Per-band limits; the defaults are the MTK driver's
+struct L1IfLimits {
+    uint32_t ext = 16;      // BSSes including the main one: ext_ifname1..15
+    uint32_t apcli = 1;
+    uint32_t wds = 4;
+    uint32_t mesh = 1;
+
+    bool operator==(const L1IfLimits& o) const {
+        return ext == o.ext && apcli == o.apcli && wds == o.wds && mesh == o.mesh;
+    }
+};
+
+// One band's claim on a stem. A base's rules are sorted by descending order,
+// so the first one that matches belongs to the block defined last, which owns
+// the name.
+struct L1IfRule {
+    uint32_t dev;           // device index, in list_devs() order
+    uint32_t order;         // device creation order
+    uint32_t key;           // L1Key: main_ifname (exact name) or a prefix key
+};
+
+// Keys that name interfaces, in the order a band's interfaces are listed
+static const L1Key L1_IF_KEYS[] = {
+    L1Key::main_ifname, L1Key::ext_ifname, L1Key::apcli_ifname, L1Key::wds_ifname, L1Key::mesh_ifname
+};
+
+// Suffix range [first, last) of a prefix key; main names take no suffix
+inline std::pair<uint32_t, uint32_t> l1_if_range(L1Key key, const L1IfLimits& lim) {
+    // Indexed rather than switched: lookups mix keys in no particular order
+    const uint32_t last[] = { 0, 0, lim.ext, lim.apcli, lim.wds, lim.mesh };
+    static_assert((int)L1Key::ext_ifname == 2 && (int)L1Key::mesh_ifname == 5, "L1Key order");
+    size_t k = (size_t)key < std::size(last) ? (size_t)key : 0;
+    return { key == L1Key::ext_ifname ? 1u : 0u, last[k] };
+}
+
+// "rax12" -> { "rax", "12" }
+inline std::pair<std::string_view, std::string_view> l1_if_split(std::string_view s) {
+    size_t b = s.size();
+    while (b > 0 && s[b - 1] >= '0' && s[b - 1] <= '9') --b;
+    return { s.substr(0, b), s.substr(b) };
+}
+
+// Value of a suffix as std::to_string() would have written it, nullopt if it
+// could not have come from there (empty, leading zero, too long)
+inline std::optional<uint64_t> l1_if_suffix(std::string_view digits) {
+    if (digits.empty() || digits.size() > 10 || (digits.size() > 1 && digits[0] == '0')) return std::nullopt;
+    uint64_t value = 0;
+    for (char c : digits) value = value * 10 + (uint64_t)(c - '0');
+    return value;
+}
+
+// Every concrete name a rule stands for, under the given limits
+template <typename Func>
+void l1_for_each_if_name(std::string_view stem, L1Key key, const L1IfLimits& lim, Func f) {
+    if (key == L1Key::main_ifname) {
+        f(stem);
+        return;
+    }
+    auto range = l1_if_range(key, lim);
+    std::string name(stem);
+    for (uint32_t j = range.first; j < range.second; ++j) {
+        name.resize(stem.size());
+        name += std::to_string(j);
+        f(std::string_view(name));
+    }
+}
+
+/**
+ * Resolve an interface name to its device index, UINT32_MAX if no band owns
+ * it. for_each_rule(base, f) calls f(rule, rule_digits) for the rules of a
+ * base in descending order and stops once f returns true. The first match is
+ * the owner, exactly as if every name had been registered block by block.
+ */
+template <typename ForEachRule>
+uint32_t l1_resolve_if(std::string_view name, const L1IfLimits& lim, ForEachRule for_each_rule) {
+    auto [base, digits] = l1_if_split(name);
+    // Suffix for the usual prefixes, which end in no digit of their own
+    std::optional<uint64_t> whole = l1_if_suffix(digits);
+
+    uint32_t dev = UINT32_MAX;
+    for_each_rule(base, [&](const L1IfRule& r, std::string_view rule_digits) {
+        bool match;
+        if (r.key == (uint32_t)L1Key::main_ifname) {
+            match = digits == rule_digits;
+        } else {
+            std::optional<uint64_t> suffix = whole;
+            if (!rule_digits.empty()) {
+                bool extends = digits.size() > rule_digits.size() &&
+                               digits.compare(0, rule_digits.size(), rule_digits) == 0;
+                suffix = extends ? l1_if_suffix(digits.substr(rule_digits.size())) : std::nullopt;
+            }
+            auto range = l1_if_range((L1Key)r.key, lim);
+            match = suffix && *suffix >= range.first && *suffix < range.second;
+        }
+        if (match) dev = r.dev;
+        return match;
+    });
+    return dev;
+}
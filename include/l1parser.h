@@ -12,9 +12,64 @@ typedef struct L1Context L1Context;
 
 /* Initialization and Cleanup */
 L1Context* l1_init();
+/* Like l1_init() for another profile file, always parsed in-process */
+L1Context* l1_init_file(const char* path);
+/*
+ * Like l1_init(), building the parsed profile in buf (size bytes) instead of
+ * heap chunks. Four times the profile size is plenty; whatever does not fit
+ * goes to the heap. The parse itself only takes a scratch block, and
+ * l1_free() releases no per-string or per-node memory. A reload is built
+ * while the previous profile still occupies buf, so it uses the heap; the
+ * load after it gets buf back. A profile answered from its compiled image
+ * or by the daemon is not parsed and leaves buf unused. buf must stay
+ * valid, and untouched, until l1_free().
+ */
+L1Context* l1_init_with_arena(void* buf, size_t size);
 void l1_free(L1Context* ctx);
 void l1_free_str_array(char** arr, size_t count);
 
+/*
+ * Reload the profile in the background whenever it changes on disk. Lookups
+ * keep working during a reload and see either the old or the new profile.
+ * Returns 0 on success, -1 if the file cannot be watched.
+ */
+int l1_watch(L1Context* ctx);
+
+/*
+ * Re-read the profile now and return what changed as JSON:
+ * {"devices": {"added": [...], "removed": [...], "modified": {dev: [keys]}},
+ *  "interfaces": {"added": [...], "removed": [...], "modified": [...]}}
+ * Unchanged INDEX blocks leave the current profile in place and give empty
+ * lists. The context answers locally from then on. NULL if the file cannot
+ * be loaded (the previous profile stays). Free with free().
+ */
+char* l1_reload(L1Context* ctx);
+
+/*
+ * Write-back. l1_set() and l1_dat_set() only stage an edit: a property of
+ * device dev in the profile, or a key of the .dat file l1_if2dat() names for
+ * ifname. l1_commit() then rewrites every touched file once, atomically
+ * (temp file and rename), keeping comments, order and all other lines as
+ * they are, and answers from the new profile right away. Edits of a file
+ * that could not be written stay staged; l1_discard() drops them all.
+ * All return 0 on success, -1 on failure (unknown device or interface,
+ * a value with a line break, '#' in the profile or ';' in a per-band
+ * property).
+ */
+int l1_set(L1Context* ctx, const char* dev, const char* key, const char* value);
+int l1_dat_set(L1Context* ctx, const char* ifname, const char* key, const char* value);
+int l1_commit(L1Context* ctx);
+void l1_discard(L1Context* ctx);
+
+/*
+ * Virtual interface limits per band: ext_ifname1..ext-1, apcli_ifname0..apcli-1,
+ * wds_ifname0..wds-1 and mesh_ifname0..mesh-1 (defaults 16, 1, 4, 1). The
+ * profile is re-read with the new limits; a context with its own limits
+ * answers locally instead of through a running daemon. _ref results switch
+ * over at the next l1_refresh(). Returns 0 on success, -1 on failure.
+ */
+int l1_set_if_limits(L1Context* ctx, unsigned int ext, unsigned int apcli, unsigned int wds, unsigned int mesh);
+
 /* Core API. Returned char* is strictly owned by the caller and must be freed using free() */
 char* l1_get(L1Context* ctx, const char* dev, const char* key);
 char** l1_list(L1Context* ctx, size_t* count);
@@ -23,11 +78,109 @@ char* l1_if2dat(L1Context* ctx, const char* ifname);
 char** l1_zone2if(L1Context* ctx, const char* zone, size_t* count);
 char* l1_if2dbdcidx(L1Context* ctx, const char* ifname);
 char* l1_idx2if(L1Context* ctx, size_t idx);
+/*
+ * Value of key in the per-band .dat file l1_if2dat() names for ifname, e.g.
+ * l1_dat_get(ctx, "ra0", "Channel"). The file is indexed on first use;
+ * later lookups do not read it again. An index is dropped when the file has
+ * changed on disk by the next l1_reload(), or right away under l1_watch().
+ */
+char* l1_dat_get(L1Context* ctx, const char* ifname, const char* key);
+/* Same for a .dat file given by path, answered in-process */
+char* l1_dat_get_file(L1Context* ctx, const char* dat_path, const char* key);
+/* The whole idx2if table: entry i is l1_idx2if(ctx, i + 1) */
+char** l1_idx_table(L1Context* ctx, size_t* count);
+/* Inverse of l1_idx2if, 0 if ifname is not a main interface */
+size_t l1_if2idx(L1Context* ctx, const char* ifname);
+
+/*
+ * Relation lookups, answered from indexes built at load. Devices come in
+ * l1_list() order, interfaces are the concrete names (ra0, ra1, apcli0...)
+ * in main/ext/apcli/wds/mesh order. Free with l1_free_str_array().
+ */
+char** l1_zone2devs(L1Context* ctx, const char* zone, size_t* count);
+char** l1_zone2ifs(L1Context* ctx, const char* zone, size_t* count);
+char** l1_dat2ifs(L1Context* ctx, const char* dat_path, size_t* count);
+char** l1_dev2ifs(L1Context* ctx, const char* dev, size_t* count);
+
+/*
+ * Batch API. Each query is an l1util command line, e.g. "if2zone ra0" or
+ * "get MT7981_1_1 profile_path". Returns an array of count answers (NULL for
+ * queries without a result) that lives in a single allocation: release it
+ * with one free() call, not l1_free_str_array().
+ */
+char** l1_query_batch(L1Context* ctx, const char* const* queries, size_t count);
+
+/*
+ * Call counters, latency histograms and the load-phase breakdown of this
+ * context as a JSON object, "enabled": false unless the library was built
+ * with ENABLE_STATS. Lookups a daemon answered are counted by the daemon.
+ * Free with free().
+ */
+char* l1_stats(L1Context* ctx);
+
+/*
+ * Memory the context's own profile holds, in bytes per structure, as JSON:
+ * {"compact": false, "strings": ..., "blocks": ..., "dev_map": ...,
+ *  "dev_keys": ..., "index": ..., "image": ..., "if_map": ...,
+ *  "relations": ..., "total": ..., "arena": ..., "arena_chunks": ...}
+ * arena is the memory strings through index were allocated from, a buffer
+ * given to l1_init_with_arena() included, and not part of total;
+ * arena_chunks counts the heap allocations it made. A context a daemon
+ * answers for holds none until a lookup is answered locally. Free with
+ * free().
+ */
+char* l1_memory_usage(L1Context* ctx);
+
+/*
+ * Compact mode for low-RAM targets: keep the profile as one packed,
+ * read-only image in memory instead of parsed maps. Answers do not change.
+ * A loaded profile is re-read in the new layout; _ref results switch over
+ * at the next l1_refresh(). Returns 0 on success, -1 on failure.
+ */
+int l1_set_compact(L1Context* ctx, int compact);
 
 /* Helper functions for iwinfo */
 char* l1_get_chip_id_by_devname(L1Context* ctx, const char* dev);
 char* l1_get_chip_id_by_ifname(L1Context* ctx, const char* ifname);
 
+/*
+ * Allocation-free API, answered in-process even when a daemon is running.
+ *
+ * _ref: borrowed strings owned by the context. They stay valid until
+ * l1_refresh() or l1_free(); they keep showing the profile as it was at the
+ * first _ref call (or the last l1_refresh()) even if l1_watch() reloads it.
+ * Do not free them.
+ */
+int l1_refresh(L1Context* ctx);
+const char* l1_get_ref(L1Context* ctx, const char* dev, const char* key);
+const char* l1_if2zone_ref(L1Context* ctx, const char* ifname);
+const char* l1_if2dat_ref(L1Context* ctx, const char* ifname);
+const char* l1_idx2if_ref(L1Context* ctx, size_t idx);
+const char* l1_get_chip_id_by_devname_ref(L1Context* ctx, const char* dev);
+const char* l1_get_chip_id_by_ifname_ref(L1Context* ctx, const char* ifname);
+/* Fill out with up to max borrowed names, return the total number available */
+size_t l1_list_ref(L1Context* ctx, const char** out, size_t max);
+size_t l1_zone2if_ref(L1Context* ctx, const char* zone, const char** out, size_t max);
+size_t l1_idx_table_ref(L1Context* ctx, const char** out, size_t max);
+size_t l1_zone2devs_ref(L1Context* ctx, const char* zone, const char** out, size_t max);
+size_t l1_zone2ifs_ref(L1Context* ctx, const char* zone, const char** out, size_t max);
+size_t l1_dat2ifs_ref(L1Context* ctx, const char* dat_path, const char** out, size_t max);
+size_t l1_dev2ifs_ref(L1Context* ctx, const char* dev, const char** out, size_t max);
+
+/*
+ * _r: copy the answer from the current profile into buf, like snprintf().
+ * Returns the full length of the value (the copy is truncated when that is
+ * >= len, and always NUL-terminated if len > 0), or -1 if there is no value.
+ */
+int l1_get_r(L1Context* ctx, const char* dev, const char* key, char* buf, size_t len);
+int l1_if2zone_r(L1Context* ctx, const char* ifname, char* buf, size_t len);
+int l1_if2dat_r(L1Context* ctx, const char* ifname, char* buf, size_t len);
+int l1_dat_get_r(L1Context* ctx, const char* ifname, const char* key, char* buf, size_t len);
+int l1_idx2if_r(L1Context* ctx, size_t idx, char* buf, size_t len);
+int l1_if2dbdcidx_r(L1Context* ctx, const char* ifname, char* buf, size_t len);
+int l1_get_chip_id_by_devname_r(L1Context* ctx, const char* dev, char* buf, size_t len);
+int l1_get_chip_id_by_ifname_r(L1Context* ctx, const char* ifname, char* buf, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,70 +1,550 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 #include <map>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <sys/stat.h>
+#include "l1schema.hpp"
+#include "l1ifrules.hpp"
+#include "l1stats.hpp"
+#include "../utils/arena.hpp"
+#include "../utils/strpool.hpp"
+#include "../utils/perfecthash.hpp"
 
 static const char* L1_DAT_PATH = "/etc/wireless/l1profile.dat";
+// Compiled image of L1_DAT_PATH, see `l1util compile`
+inline constexpr const char* L1_CACHE_PATH = "/var/run/l1profile.cache";
+// Query socket of a resident `l1util serve` daemon
+static const char* L1_SOCK_PATH = "/var/run/l1parser.sock";
 
-// Represents a single Radio/Band configuration (e.g., MT7981_1_1)
+/*
+ * One INDEXn block, stored by column. Every property is split once into
+ * consecutive cells, one per band; a property all bands share (INDEX,
+ * EEPROM_*, mainidx) has a single cell. All views are interned in the
+ * owning L1Snapshot and live as long as it does; so do the columns, which
+ * come from its arena.
+ */
+struct L1Block {
+    struct Column {
+        uint32_t first;     // cell of band 0
+        bool shared;        // one cell for every band
+    };
+
+    std::string_view index_name; // e.g. "MT7981"
+    size_t raw_idx = 0;     // n of its INDEXn lines
+    size_t main_idx = 0;    // Chipset index (1st, 2nd of its kind)
+    size_t bands = 0;
+    std::pmr::vector<std::string_view> cells;
+    // Well-known properties (see l1schema.hpp), set where known_mask has the bit
+    std::array<Column, L1_KEY_COUNT> known;
+    uint32_t known_mask = 0;
+    // Every other property
+    std::pmr::unordered_map<std::string_view, Column> extra;
+
+    explicit L1Block(std::pmr::memory_resource* mr = std::pmr::get_default_resource()) : cells(mr), extra(mr) {}
+
+    static constexpr uint32_t bit(L1Key k) { return 1u << (unsigned)k; }
+
+    std::string_view cell(Column c, size_t band) const { return cells[c.shared ? c.first : c.first + band]; }
+
+    std::optional<std::string_view> get(L1Key k, size_t band) const {
+        if (known_mask & bit(k)) return cell(known[(size_t)k], band);
+        return std::nullopt;
+    }
+    std::optional<std::string_view> get(std::string_view key, size_t band) const {
+        if (auto k = l1_key(key)) return get(*k, band);
+        auto it = extra.find(key);
+        if (it != extra.end()) return cell(it->second, band);
+        return std::nullopt;
+    }
+    // Column of the cells appended since first
+    void set(L1Key k, uint32_t first, bool shared) {
+        known[(size_t)k] = { first, shared };
+        known_mask |= bit(k);
+    }
+    void set(std::string_view key, uint32_t first, bool shared) {
+        if (auto k = l1_key(key)) set(*k, first, shared);
+        else extra[key] = { first, shared };
+    }
+
+    // Visit every property of a band as (key, value), known slots first
+    template <typename Func>
+    void for_each(size_t band, Func f) const {
+        for (size_t i = 0; i < L1_KEY_COUNT; ++i) {
+            if (known_mask & bit((L1Key)i)) f(L1_KEY_NAMES[i], cell(known[i], band));
+        }
+        for (const auto& kv : extra) f(kv.first, cell(kv.second, band));
+    }
+};
+
+// Represents a single Radio/Band configuration (e.g., MT7981_1_1): a band
+// of the L1Block it was declared in, which the owning L1Snapshot keeps.
 struct L1Entry {
-    std::string index_name; // e.g. "MT7981"
+    std::string_view index_name; // e.g. "MT7981"
     size_t main_idx;        // Chipset index (1st, 2nd of its kind)
     size_t sub_idx;         // Band index (1, 2...)
-    std::unordered_map<std::string, std::string> props;
+    const L1Block* block;
+    size_t band;            // column cell of this entry in block
+
+    std::optional<std::string_view> get(L1Key k) const { return block->get(k, band); }
+    std::optional<std::string_view> get(std::string_view key) const { return block->get(key, band); }
+
+    // Visit every property as (key, value), known slots first
+    template <typename Func>
+    void for_each(Func f) const { block->for_each(band, f); }
 };
 
-// Represents a raw block in the config file, used for sequential indexing
-struct RawBlock {
-    size_t raw_index;
-    std::vector<std::string> main_ifnames;
+// Outcome of a text command, see L1Snapshot::query()
+enum class L1Status {
+    Ok,         // value holds the answer (lists are space separated)
+    NotFound,   // well-formed command, nothing matched
+    BadRequest, // unknown command or wrong arguments, value may hold a reason
 };
 
-class L1Parser {
+struct L1Reply {
+    L1Status status;
+    std::string value;
+
+    // Line format shared by `l1util batch` and the daemon protocol:
+    // "OK <value>", "NONE" or "ERR [reason]", without the trailing newline
+    std::string to_line() const;
+    static L1Reply from_line(std::string_view line);
+};
+
+// What changed between two snapshots, see L1Parser::reload(). Devices and
+// interfaces come in list_devs() / dev2ifs() order, removed ones in the
+// order of the older snapshot.
+struct L1Diff {
+    std::vector<std::string> devs_added, devs_removed;
+    // Device -> keys whose value changed, appeared or disappeared (sorted)
+    std::vector<std::pair<std::string, std::vector<std::string>>> devs_modified;
+    std::vector<std::string> ifs_added, ifs_removed;
+    // Still present, but owned by another device or by a modified one
+    std::vector<std::string> ifs_modified;
+
+    bool empty() const {
+        return devs_added.empty() && devs_removed.empty() && devs_modified.empty() &&
+               ifs_added.empty() && ifs_removed.empty() && ifs_modified.empty();
+    }
+    // {"devices": {"added": [], "removed": [], "modified": {dev: [keys]}},
+    //  "interfaces": {"added": [], "removed": [], "modified": []}}
+    std::string to_json() const;
+};
+
+// Output formats of L1Snapshot::export_to()
+enum class L1ExportFormat {
+    Shell,      // eval-able assignments
+    Json,
+    Kv,         // dev.<dev>.<key>=<value> lines
+};
+
+class L1Image;
+class L1ImageWriter;
+class L1Parser;
+class L1Watcher;
+
+/*
+ * One fully built, immutable revision of the profile. L1Parser publishes a
+ * new snapshot on every (re)load; callers that need several consistent
+ * lookups, or references that survive a reload, hold one via
+ * L1Parser::snapshot(). All views handed out stay valid while it is held.
+ */
+class L1Snapshot : public std::enable_shared_from_this<L1Snapshot> {
 public:
-    L1Parser();
-    bool load(const std::string path);
+    ~L1Snapshot();
+    L1Snapshot(const L1Snapshot&) = delete;
+    L1Snapshot& operator=(const L1Snapshot&) = delete;
+
+    // Write the loaded profile as a compiled image (see L1Image)
+    bool compile(const std::string& out_path) const;
+    // Stream every device property, interface owner and idx2if entry to fd
+    // in one pass (see lib/export.cpp for the layouts). false with errno
+    // set on a write error, or EEXIST if two names collide as shell variables.
+    bool export_to(int fd, L1ExportFormat format) const;
+    // Devices, properties and interfaces that differ from an older snapshot
+    L1Diff diff(const L1Snapshot& older) const;
+    bool from_image() const { return image_ != nullptr; }
+    // Bytes held per structure (lib/memory.cpp)
+    L1MemUsage memory_usage() const;
+    const std::string& src_path() const { return src_path_; }
+    // Virtual interface limits this snapshot resolves names with
+    const L1IfLimits& if_limits() const { return if_limits_; }
+#ifdef L1_ENABLE_STATS
+    // How the load that built this snapshot went
+    const L1LoadStats& load_stats() const { return load_stats_; }
+#endif
 
     // Core logic getters
-    const std::unordered_map<std::string, L1Entry>& get_all() const { return dev_map_; }
+    const std::pmr::unordered_map<std::string_view, L1Entry>& get_all() const;
     std::optional<std::string> get_prop(const std::string& dev, const std::string& key) const;
     std::vector<std::string> list_devs() const;
     std::optional<std::string> if2zone(const std::string& ifname) const;
     std::optional<std::string> if2dat(const std::string& ifname) const;
+    // Value of key in the per-band .dat file if2dat(ifname) names, indexed
+    // on first use and cached per path (see lib/l1dat.hpp)
+    std::optional<std::string> dat_get(const std::string& ifname, const std::string& key) const;
     std::optional<std::string> if2dbdcidx(const std::string& ifname) const;
     std::vector<std::string> zone2if(const std::string& zone) const;
     std::optional<std::string> idx2if(size_t target) const;
+    // Every idx2if answer at once, entry i is idx2if(i + 1)
+    std::vector<std::string> idx_table() const;
+
+    // Answer one l1util-style command, e.g. { "if2zone", "ra0" }
+    L1Reply query(const std::vector<std::string_view>& args) const;
+    // Same, for a whitespace separated command line ("get MT7981_1_1 nvram_zone")
+    L1Reply query(std::string_view line) const;
+    // Answer a single-value command straight from profile text, without
+    // building a snapshot (lib/oneshot.cpp). nullopt for commands it does
+    // not cover: query() a loaded snapshot instead.
+    static std::optional<L1Reply> scan_query(std::string_view buf, const std::vector<std::string_view>& args,
+                                             const L1IfLimits& limits = L1IfLimits());
 
     // Additional helpers
-    const std::unordered_map<std::string, L1Entry>& get_if_map() const { return if_map_; }
+    // Interface names point at the shared entry owned by get_all()
+    const std::unordered_map<std::string_view, const L1Entry*>& get_if_map() const;
+    std::optional<std::string> get_if_prop(const std::string& ifname, const std::string& key) const;
+
+    // Borrowed lookups: no allocation, results are NUL-terminated views that
+    // live as long as this snapshot
+    std::optional<std::string_view> prop_view(std::string_view dev, std::string_view key) const;
+    std::optional<std::string_view> if_prop_view(std::string_view ifname, std::string_view key) const;
+    std::optional<std::string_view> prop_view(std::string_view dev, L1Key key) const;
+    std::optional<std::string_view> if_prop_view(std::string_view ifname, L1Key key) const;
+    std::optional<std::string_view> idx2if_view(size_t target) const;
+    // Sequential main interface table: idx2if(n) == seq_if(n - 1)
+    size_t seq_count() const;
+    std::string_view seq_if(size_t i) const;
+    // Inverse of idx2if, 1-based
+    std::optional<size_t> if2idx(std::string_view ifname) const;
+    std::optional<size_t> if_sub_idx(std::string_view ifname) const;
+    // Device keys in list_devs() order
+    size_t dev_count() const;
+    std::string_view dev_key(size_t i) const;
+    // Stores up to max interfaces of the zone in out, returns how many there are
+    size_t zone2if_views(std::string_view zone, std::string_view* out, size_t max) const;
+
+    // Relation indexes, one hash lookup each. Devices are in list_devs()
+    // order; a device's interfaces are the concrete names it owns (main, ext,
+    // apcli, wds, mesh), in that order. Unknown keys give an empty list.
+    const std::vector<std::string_view>& zone2devs(std::string_view zone) const;
+    const std::vector<std::string_view>& zone2ifs(std::string_view zone) const;
+    const std::vector<std::string_view>& dat2ifs(std::string_view dat_path) const;
+    const std::vector<std::string_view>& dev2ifs(std::string_view dev) const;
 
 private:
-    std::unordered_map<std::string, L1Entry> dev_map_; // Map by Device ID: "MT7981_1_1"
-    std::unordered_map<std::string, L1Entry> if_map_;  // Map by Interface: "ra0", "apcli0"
-    std::vector<RawBlock> raw_blocks_;
-    std::vector<std::string> ordered_dev_keys_;
+    friend class L1Parser;
+    L1Snapshot();
 
-    // Map RawIndex -> { PropertyKey -> Value }
-    using RawDataMap = std::map<size_t, std::unordered_map<std::string, std::string>>;
+    // Build steps, each runs once on a fresh snapshot before it is published
+    bool load(const std::string& path, bool use_cache);
+    bool load_from_fd(int fd);
+    bool load_from_buffer(std::string_view buf);
+    // The same profile as a packed in-memory image only, for compact mode;
+    // nullptr if this snapshot already is an image or the image fails
+    std::shared_ptr<L1Snapshot> compacted() const;
 
-    RawDataMap parse_raw_config(const std::string& path);
+    // Backs everything the build produces, from the pool to the hash tables
+    // below: a parse takes one chunk sized from the text (or the buffer lent
+    // through L1Parser::set_arena()) and the snapshot returns it in one go.
+    // Only the build and materialize() allocate from it; structures built
+    // on first use by concurrent readers (if_map_, rel_) stay on the heap.
+    mutable utils::Arena arena_;
 
+    // Owns every key, value, device key and interface name referenced below
+    utils::StringPool pool_{ &arena_ };
+
+    // Columns of every block; reserved up front so entries can point into
+    // it. From an image, one single-band block per device is filled in
+    // with the map views.
+    mutable std::pmr::vector<L1Block> blocks_{ &arena_ };
+    // When loaded from an image, dev_map_ stays empty until a caller asks for
+    // the map views; lookups are answered from the image directly. if_map_
+    // is only ever expanded from the interface rules on request.
+    mutable std::pmr::unordered_map<std::string_view, L1Entry> dev_map_{ &arena_ }; // Map by Device ID: "MT7981_1_1"
+    mutable std::unordered_map<std::string_view, const L1Entry*> if_map_;  // Map by Interface: "ra0", "apcli0"
+    mutable utils::StringPool if_names_;    // names expanded into if_map_
+    mutable std::once_flag devs_materialized_, materialized_;
+    // Set once if_map_ exists, for memory_usage()
+    mutable std::atomic<bool> materialized_done_{ false };
+
+    using RelationMap = std::unordered_map<std::string_view, std::vector<std::string_view>>;
+    struct Relations {
+        RelationMap zone_devs, zone_ifs, dat_ifs, dev_ifs;
+        std::unordered_map<std::string_view, size_t> if_seq; // inverse of idx2if
+        utils::StringPool names;    // virtual interface names listed above
+    };
+    // Built on first use
+    mutable Relations rel_;
+    mutable std::once_flag relations_built_;
+    mutable std::atomic<bool> relations_done_{ false };
+    // Fingerprint of every INDEX block as parsed, by raw index; an image
+    // carries those of its source. A reload whose blocks all match its base_
+    // (the snapshot it replaces) stops after tokenizing, or after opening
+    // the image, and sets unchanged_ instead of building anything. Otherwise
+    // blocks that match a parsed base_ are copied from it, see reuse_block().
+    std::pmr::vector<std::pair<size_t, uint64_t>> block_fps_{ &arena_ };
+    const L1Snapshot* base_ = nullptr;
+    bool unchanged_ = false;
+    // Main interfaces of all blocks in file order; idx2if(n) is seq_ifs_[n - 1]
+    std::pmr::vector<std::string_view> seq_ifs_{ &arena_ };
+    std::pmr::vector<std::string_view> ordered_dev_keys_{ &arena_ };
+
+    // Minimal perfect hashes over the device keys and the interface bases:
+    // one hash, one table read and one comparison per lookup
+    using NameSlot = std::pair<std::string_view, const L1Entry*>;
+    utils::PerfectHash dev_hash_{ &arena_ }, if_hash_{ &arena_ };
+    std::pmr::vector<NameSlot> dev_slots_{ &arena_ };
+    // Interface rules (see l1ifrules.hpp) grouped by base; if_bases_ is in
+    // hash slot order, or sorted by name if the hash could not be built
+    struct IfBase {
+        std::string_view name;
+        uint32_t first, count;  // range in if_rules_
+    };
+    std::pmr::vector<IfBase> if_bases_{ &arena_ };
+    std::pmr::vector<L1IfRule> if_rules_{ &arena_ };
+    std::pmr::vector<std::string_view> if_digits_{ &arena_ };   // trailing digits of each rule's stem
+    std::pmr::vector<const L1Entry*> dev_entries_{ &arena_ };   // in ordered_dev_keys_ order
+    L1IfLimits if_limits_;
+
+    std::unique_ptr<L1Image> image_;
+    bool compact_ = false;      // image_ was built in memory, not mapped
+    std::string src_path_;
+    struct stat src_st_ = {};
+#ifdef L1_ENABLE_STATS
+    L1LoadStats load_stats_;
+#endif
+
+    // dev_map_ of an image; materialize() also expands if_map_
+    void materialize_devs() const;
+    void materialize() const;
+    // Properties of a device sorted by key, read from the entry or the
+    // image in place; false if dev is unknown
+    using PropList = std::vector<std::pair<std::string_view, std::string_view>>;
+    bool sorted_props(std::string_view dev, PropList& out) const;
+    void add_to_image(L1ImageWriter& w) const;
+    // tmp holds what only lives for the build (see load_from_buffer())
+    void build_hashes(std::pmr::memory_resource* tmp);
+    void build_if_rules(const std::pmr::vector<std::string_view>& created, std::pmr::memory_resource* tmp);
+    const L1Entry* find_dev_entry(std::string_view key) const;
+    const IfBase* find_if_base(std::string_view base) const;
+    // Device index owning an interface name, UINT32_MAX if none
+    uint32_t find_if_dev(std::string_view name) const;
+    const L1Entry* find_if_entry(std::string_view name) const;
+    template <typename Func>
+    void for_each_if_rule(Func f) const;
+    void build_relations() const;
+    const std::vector<std::string_view>& relation(const RelationMap& map, std::string_view key) const;
+
+    // Map RawIndex -> { PropertyKey -> Value }, views into the source buffer
+    using RawProps = std::pmr::unordered_map<std::string_view, std::string_view>;
+    using RawDataMap = std::pmr::map<size_t, RawProps>;
+
+    RawDataMap parse_raw_config(std::string_view buf, std::pmr::memory_resource* tmp);
+    static uint64_t block_fingerprint(const RawProps& props);
+    // base_ describes the same profile, block for block
+    bool same_blocks_as_base() const;
+
+    // Blocks of base_ whose text is unchanged, by raw index
+    using ReusableBlocks = std::pmr::unordered_map<size_t, const L1Block*>;
     void process_block(size_t raw_idx, 
-                       const std::unordered_map<std::string, std::string>& props,
-                       std::unordered_map<std::string, size_t>& chipset_counter);
-
-    void create_and_map_entry(const std::string& chip_name,
-                              size_t main_idx,
-                              size_t sub_idx,
-                              size_t raw_idx,
-                              size_t band_index, // 0-based index in main_ifnames
-                              const std::string& current_main_if,
-                              const std::unordered_map<std::string, std::string>& props);
-
-    static std::optional<std::pair<size_t, std::string>> parse_index_key(const std::string& key);          
+                       const RawProps& props,
+                       std::pmr::unordered_map<std::string_view, size_t>& chipset_counter,
+                       const ReusableBlocks& reusable,
+                       std::pmr::memory_resource* tmp);
+    // Copy the columns of an unchanged block instead of splitting its text
+    void reuse_block(const L1Block& old);
+
+    void create_and_map_entry(const L1Block& block, size_t band);
+
+    static std::optional<std::pair<size_t, std::string_view>> parse_index_key(std::string_view key);
+    // Properties shared by every band of a block; all others hold one
+    // ';' separated field per band
+    static bool is_block_prop(std::string_view key);
+};
+
+/*
+ * Entry point for profile lookups. Each load publishes a new L1Snapshot with
+ * an atomic pointer swap; lookups never take a lock and always see one
+ * complete snapshot. A replaced snapshot is released once no lookup is still
+ * running on it (callers holding snapshot() keep theirs alive).
+ */
+class L1Parser {
+public:
+    L1Parser();
+    ~L1Parser();
+    L1Parser(const L1Parser&) = delete;
+    L1Parser& operator=(const L1Parser&) = delete;
+
+    // Load a profile. With use_cache, a valid compiled image at L1_CACHE_PATH
+    // is mapped instead of reparsing the source file. On failure the
+    // previously loaded snapshot stays in place.
+    bool load(const std::string path, bool use_cache = true);
+    // Parse an already open profile (mmap'ed when it is a regular file)
+    bool load_from_fd(int fd);
+    // Parse a caller-supplied profile text; buf only needs to outlive the call
+    bool load_from_buffer(std::string_view buf);
+    // L1Snapshot::scan_query() on the file at path, nullopt if not covered
+    // or the file cannot be read
+    static std::optional<L1Reply> query_file(const std::string& path, const std::vector<std::string_view>& args,
+                                             const L1IfLimits& limits = L1IfLimits());
+
+    // Re-read the file given to load() and publish the result. A file whose
+    // INDEX blocks all parse the same as before keeps the current snapshot.
+    // With diff, also report what changed (empty if nothing did).
+    bool reload(L1Diff* diff = nullptr);
+    // Reload automatically whenever that file changes (inotify, background
+    // thread). Also keeps watching the .dat files dat_get() has read.
+    bool watch();
+    void unwatch();
+
+    // Virtual interface limits used from now on. A profile loaded from a file
+    // is re-read right away so lookups switch over; other profiles keep their
+    // limits until the next load.
+    bool set_if_limits(const L1IfLimits& limits);
+
+    // Compact mode: keep each loaded profile only as a packed image built in
+    // memory (the layout of `l1util compile`, one read-only region with
+    // 32-bit offsets) instead of the parsed maps. Lookups answer the same,
+    // at the image's speed. Applies like set_if_limits(). The build option
+    // COMPACT makes it the default.
+    bool set_compact(bool compact);
+    // Bytes the current snapshot holds, see L1MemUsage
+    L1MemUsage memory_usage() const;
+    // Build the snapshots of later loads in buf (size bytes) rather than
+    // heap chunks, as long as it lasts. Only one snapshot uses it at a time:
+    // a reload, built while the previous snapshot still holds buf, goes to
+    // the heap. Meant to be called once, before the first load; buf must
+    // outlive this parser and every snapshot() handed out.
+    void set_arena(void* buf, size_t size);
+
+    // The current snapshot, valid for as long as the caller holds it
+    std::shared_ptr<const L1Snapshot> snapshot() const;
+
+    bool compile(const std::string& out_path) const;
+    bool export_to(int fd, L1ExportFormat format) const;
+    bool from_image() const;
+
+    // Core logic getters, each answered from one consistent snapshot.
+    // get_all() and get_if_map() reference the current snapshot and are only
+    // valid until the next reload; use snapshot() when watching.
+    const std::pmr::unordered_map<std::string_view, L1Entry>& get_all() const;
+    std::optional<std::string> get_prop(const std::string& dev, const std::string& key) const;
+    std::vector<std::string> list_devs() const;
+    std::optional<std::string> if2zone(const std::string& ifname) const;
+    std::optional<std::string> if2dat(const std::string& ifname) const;
+    std::optional<std::string> dat_get(const std::string& ifname, const std::string& key) const;
+    std::optional<std::string> if2dbdcidx(const std::string& ifname) const;
+    std::vector<std::string> zone2if(const std::string& zone) const;
+    std::optional<std::string> idx2if(size_t target) const;
+    std::vector<std::string> idx_table() const;
+    std::optional<size_t> if2idx(const std::string& ifname) const;
+
+    L1Reply query(const std::vector<std::string_view>& args) const;
+    L1Reply query(std::string_view line) const;
+
+    // Relation lookups, see L1Snapshot::zone2devs()
+    std::vector<std::string> zone2devs(const std::string& zone) const;
+    std::vector<std::string> zone2ifs(const std::string& zone) const;
+    std::vector<std::string> dat2ifs(const std::string& dat_path) const;
+    std::vector<std::string> dev2ifs(const std::string& dev) const;
+
+    // Additional helpers
+    const std::unordered_map<std::string_view, const L1Entry*>& get_if_map() const;
+    std::optional<std::string> get_if_prop(const std::string& ifname, const std::string& key) const;
+
+    // Call counters, latencies and the current snapshot's load breakdown
+    // (see l1stats.hpp); enabled is false when built without them
+    L1Stats stats() const;
+#ifdef L1_ENABLE_STATS
+    // For wrappers that answer from a snapshot() directly
+    L1StatsRecorder& stats_recorder() const { return stats_; }
+#endif
+
+    // Write-back (lib/writeback.cpp). Edits are only staged here: commit()
+    // rewrites each touched file once, through a temp file and rename(),
+    // and leaves every other line (comments, order, spacing) untouched.
+    // set_prop() changes the band of dev in the loaded profile, set_dat() a
+    // key of ifname's .dat file. Both return false for unknown devices or
+    // interfaces and for values the file could not hold (line breaks, '#'
+    // in the profile, ';' in a per-band property).
+    bool set_prop(const std::string& dev, const std::string& key, const std::string& value);
+    bool set_dat(const std::string& ifname, const std::string& key, const std::string& value);
+    // Write all staged edits and publish the new profile from memory. Edits
+    // of a file that could not be written stay staged.
+    bool commit();
+    void discard();
+
+private:
+    class ReadGuard;
+
+    // Empty snapshot for the current limits and arena buffer
+    std::shared_ptr<L1Snapshot> new_snapshot() const;
+    void publish(std::shared_ptr<L1Snapshot> snap);
+    bool load_locked(const std::string& path, bool use_cache, L1Diff* diff = nullptr, bool incremental = false);
+
+    // (dev, key) -> value; .dat path -> key -> value
+    using StagedProps = std::map<std::pair<std::string, std::string>, std::string>;
+    using StagedDat = std::map<std::string, std::string, std::less<>>;
+    static bool rewrite_profile(std::string_view buf, const StagedProps& edits, std::string& out);
+
+    // Readers register in readers_[epoch_ & 1], then load current_. Writers
+    // swap current_, flip epoch_ and wait for the old epoch's readers to drain
+    // before dropping the previous owner reference. New readers count against
+    // the other slot, so a steady stream of lookups cannot stall a reload.
+    std::atomic<const L1Snapshot*> current_;
+    std::atomic<unsigned> epoch_;
+    mutable std::atomic<long> readers_[2];
+    std::shared_ptr<const L1Snapshot> owner_;
+    std::mutex write_mutex_;
+
+    std::string path_;
+    bool use_cache_ = true;
+    bool compact_ = false;
+    L1IfLimits if_limits_;
+    std::shared_ptr<utils::ArenaBuffer> arena_buf_;
+    std::unique_ptr<L1Watcher> watcher_;
+    // Staged write-back, guarded by write_mutex_
+    StagedProps staged_props_;
+    std::map<std::string, StagedDat> staged_dats_;
+#ifdef L1_ENABLE_STATS
+    mutable L1StatsRecorder stats_;
+#endif
+};
+
+// Client side of the `l1util serve` protocol: one command line per request,
+// one reply line per command, answered in order so requests can be pipelined.
+class L1Client {
+public:
+    ~L1Client();
+
+    // Connect to a running daemon, nullptr if none is listening
+    static std::unique_ptr<L1Client> connect(const std::string& sock_path = L1_SOCK_PATH);
+
+    // Join arguments into a request line. Fails for arguments the line
+    // protocol cannot carry (empty or containing whitespace).
+    static std::optional<std::string> encode(const std::vector<std::string_view>& args);
+
+    // One round trip. nullopt means the connection is unusable.
+    std::optional<L1Reply> query(std::string_view line);
+    // Send every line before reading the replies
+    std::optional<std::vector<L1Reply>> query(const std::vector<std::string>& lines);
+
+private:
+    explicit L1Client(int fd) : fd_(fd) {}
+
+    bool send_all(const std::string& data);
+    bool read_line(std::string& line);
+
+    int fd_;
+    std::string rbuf_;
 };
 
 // template to catch all exceptions not to propagate to C
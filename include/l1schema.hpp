@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/*
+ * Well-known l1profile properties. Entries keep these in fixed slots indexed
+ * by L1Key instead of hashing the key string on every lookup; anything else
+ * goes to a per-entry overflow map.
+ *
+ * The slot layout is part of the compiled image: appending or reordering
+ * keys requires bumping L1_IMAGE_VERSION.
+ */
+enum class L1Key : uint8_t {
+    INDEX,
+    main_ifname,
+    ext_ifname,
+    apcli_ifname,
+    wds_ifname,
+    mesh_ifname,
+    nvram_zone,
+    profile_path,
+    EEPROM_name,
+    EEPROM_offset,
+    EEPROM_size,
+    single_sku_path,
+    bf_sku_path,
+    bs_data_path,
+    init_script,
+    init_compatible,
+    resource,
+    mainidx,    // derived: chipset index
+    subidx,     // derived: band index
+    Count
+};
+
+static constexpr size_t L1_KEY_COUNT = (size_t)L1Key::Count;
+
+static constexpr std::string_view L1_KEY_NAMES[L1_KEY_COUNT] = {
+    "INDEX",
+    "main_ifname",
+    "ext_ifname",
+    "apcli_ifname",
+    "wds_ifname",
+    "mesh_ifname",
+    "nvram_zone",
+    "profile_path",
+    "EEPROM_name",
+    "EEPROM_offset",
+    "EEPROM_size",
+    "single_sku_path",
+    "bf_sku_path",
+    "bs_data_path",
+    "init_script",
+    "init_compatible",
+    "resource",
+    "mainidx",
+    "subidx",
+};
+
+constexpr std::string_view l1_key_name(L1Key k) {
+    return L1_KEY_NAMES[(size_t)k];
+}
+
+// Length plus the 2nd and 2nd-to-last characters tell every known key apart
+constexpr uint32_t l1_key_code(std::string_view s) {
+    if (s.size() < 2) return (uint32_t)s.size();
+    return (uint32_t)s.size() << 16 | (uint32_t)(uint8_t)s[1] << 8 | (uint8_t)s[s.size() - 2];
+}
+
+/**
+ * Resolve a property name to its slot, nullopt for unknown keys. One switch
+ * on l1_key_code() (a colliding key would be a duplicate case label, i.e. a
+ * compile error) and one comparison to confirm.
+ */
+constexpr std::optional<L1Key> l1_key(std::string_view name) {
+    L1Key k = L1Key::Count;
+    switch (l1_key_code(name)) {
+    case l1_key_code("INDEX"):           k = L1Key::INDEX; break;
+    case l1_key_code("main_ifname"):     k = L1Key::main_ifname; break;
+    case l1_key_code("ext_ifname"):      k = L1Key::ext_ifname; break;
+    case l1_key_code("apcli_ifname"):    k = L1Key::apcli_ifname; break;
+    case l1_key_code("wds_ifname"):      k = L1Key::wds_ifname; break;
+    case l1_key_code("mesh_ifname"):     k = L1Key::mesh_ifname; break;
+    case l1_key_code("nvram_zone"):      k = L1Key::nvram_zone; break;
+    case l1_key_code("profile_path"):    k = L1Key::profile_path; break;
+    case l1_key_code("EEPROM_name"):     k = L1Key::EEPROM_name; break;
+    case l1_key_code("EEPROM_offset"):   k = L1Key::EEPROM_offset; break;
+    case l1_key_code("EEPROM_size"):     k = L1Key::EEPROM_size; break;
+    case l1_key_code("single_sku_path"): k = L1Key::single_sku_path; break;
+    case l1_key_code("bf_sku_path"):     k = L1Key::bf_sku_path; break;
+    case l1_key_code("bs_data_path"):    k = L1Key::bs_data_path; break;
+    case l1_key_code("init_script"):     k = L1Key::init_script; break;
+    case l1_key_code("init_compatible"): k = L1Key::init_compatible; break;
+    case l1_key_code("resource"):        k = L1Key::resource; break;
+    case l1_key_code("mainidx"):         k = L1Key::mainidx; break;
+    case l1_key_code("subidx"):          k = L1Key::subidx; break;
+    default: return std::nullopt;
+    }
+    if (l1_key_name(k) != name) return std::nullopt;
+    return k;
+}
+
+// The switch and the name table must agree
+constexpr bool l1_schema_consistent() {
+    for (size_t i = 0; i < L1_KEY_COUNT; ++i) {
+        auto k = l1_key(L1_KEY_NAMES[i]);
+        if (!k || (size_t)*k != i) return false;
+    }
+    return true;
+}
+static_assert(l1_schema_consistent(), "L1_KEY_NAMES and l1_key() disagree");
+static_assert(L1_KEY_COUNT <= 32, "known-key masks are 32 bits wide");
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+ * Runtime instrumentation: per-API call counters and latency histograms on
+ * L1Parser, plus a phase breakdown of the load that produced each snapshot.
+ *
+ * Only built with L1_ENABLE_STATS (cmake -DENABLE_STATS=ON). Without it the
+ * recording macros expand to nothing, L1Parser carries no counters and
+ * L1Parser::stats() reports enabled = false.
+ */
+
+// Lookups that are counted, one counter set each
+enum class L1Api : uint8_t {
+    get_prop, get_if_prop, list_devs, if2zone, if2dat, if2dbdcidx, zone2if,
+    idx2if, idx_table, if2idx, zone2devs, zone2ifs, dat2ifs, dev2ifs, query,
+    dat_get, Count
+};
+
+static const size_t L1_API_COUNT = (size_t)L1Api::Count;
+
+inline const char* l1_api_name(L1Api api) {
+    static const char* names[L1_API_COUNT] = {
+        "get", "getif", "list", "if2zone", "if2dat", "if2dbdcidx", "zone2if",
+        "idx2if", "idxtable", "if2idx", "zone2devs", "zone2ifs", "dat2ifs", "dev2ifs", "query",
+        "datget",
+    };
+    return (size_t)api < L1_API_COUNT ? names[(size_t)api] : "";
+}
+
+// Where a load spends its time. Phases do not overlap: blocks excludes the
+// entries it creates.
+enum class L1LoadPhase : uint8_t {
+    read,       // open, fstat and mmap the profile, or map and check the image
+    tokenize,   // parse_raw_config()
+    blocks,     // process_block()
+    entries,    // create_and_map_entry()
+    sort,       // ordering device keys
+    index,      // perfect hashes and interface rules
+    Count
+};
+
+static const size_t L1_LOAD_PHASE_COUNT = (size_t)L1LoadPhase::Count;
+
+inline const char* l1_load_phase_name(L1LoadPhase phase) {
+    static const char* names[L1_LOAD_PHASE_COUNT] = { "read", "tokenize", "blocks", "entries", "sort", "index" };
+    return (size_t)phase < L1_LOAD_PHASE_COUNT ? names[(size_t)phase] : "";
+}
+
+// Latency buckets: bucket i counts calls under 2^(i + 7) ns (128 ns, 256 ns,
+// ...), the last one everything slower
+static const size_t L1_STATS_BUCKETS = 16;
+
+inline uint64_t l1_stats_bucket_limit_ns(size_t bucket) {
+    return bucket + 1 < L1_STATS_BUCKETS ? (uint64_t)1 << (bucket + 7) : UINT64_MAX;
+}
+
+struct L1ApiStats {
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    uint64_t hist[L1_STATS_BUCKETS] = {};
+};
+
+// The load behind one snapshot
+struct L1LoadStats {
+    bool from_image = false;
+    uint64_t phase_ns[L1_LOAD_PHASE_COUNT] = {};
+    uint64_t bytes = 0;         // profile size
+    uint64_t blocks = 0;        // INDEX blocks
+    uint64_t blocks_reused = 0; // copied unchanged from the snapshot a reload replaced
+    uint64_t entries = 0;       // devices
+    uint64_t main_ifs = 0;      // main interfaces (idx2if table)
+    uint64_t if_rules = 0;      // interface naming rules, see l1ifrules.hpp
+};
+
+struct L1Stats {
+    bool enabled = false;
+    uint64_t loads = 0;         // successful loads and reloads
+    uint64_t load_failures = 0;
+    L1LoadStats last_load;      // of the current snapshot
+    L1ApiStats api[L1_API_COUNT];
+};
+
+// {"enabled": ..., "loads": ..., "last_load": {...}, "api": {"if2zone": {...}}}
+// APIs that were never called are left out.
+std::string l1_stats_json(const L1Stats& stats);
+
+/*
+ * Memory held by one snapshot, in bytes per structure (see
+ * L1Snapshot::memory_usage()). Container overhead is estimated from sizes
+ * and capacities; indexes built on first use count once they exist.
+ * Available in every build, not only with L1_ENABLE_STATS.
+ */
+struct L1MemUsage {
+    bool compact = false;       // answered from a packed image built in memory
+    uint64_t strings = 0;       // interned keys, values and names
+    uint64_t blocks = 0;        // per-block columns
+    uint64_t dev_map = 0;       // device key -> entry
+    uint64_t dev_keys = 0;      // sorted device keys and their entries
+    uint64_t index = 0;         // perfect hashes, interface rules, idx2if table
+    uint64_t image = 0;         // compiled image, mapped file or compact region
+    uint64_t if_map = 0;        // get_if_map() expansion
+    uint64_t relations = 0;     // zone, dat and device relation indexes
+    // Backing of strings through index: bytes the snapshot's arena reserved
+    // (a lent buffer included) and the heap chunks it took. Not in total().
+    uint64_t arena = 0;
+    uint64_t arena_chunks = 0;
+
+    uint64_t total() const {
+        return strings + blocks + dev_map + dev_keys + index + image + if_map + relations;
+    }
+};
+
+// {"compact": ..., "strings": ..., ..., "total": ..., "arena": ..., "arena_chunks": ...}
+std::string l1_mem_json(const L1MemUsage& mem);
+
+#ifdef L1_ENABLE_STATS
+
+// Lock-free counters behind L1Parser::stats()
+class L1StatsRecorder {
+public:
+    void record(L1Api api, uint64_t ns) {
+        Counters& c = api_[(size_t)api];
+        size_t bucket = 0;
+        while (bucket + 1 < L1_STATS_BUCKETS && ns >= l1_stats_bucket_limit_ns(bucket)) ++bucket;
+        c.calls.fetch_add(1, std::memory_order_relaxed);
+        c.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        c.hist[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_load(bool ok) { (ok ? loads_ : load_failures_).fetch_add(1, std::memory_order_relaxed); }
+
+    void fill(L1Stats& out) const {
+        out.enabled = true;
+        out.loads = loads_.load(std::memory_order_relaxed);
+        out.load_failures = load_failures_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < L1_API_COUNT; ++i) {
+            out.api[i].calls = api_[i].calls.load(std::memory_order_relaxed);
+            out.api[i].total_ns = api_[i].total_ns.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < L1_STATS_BUCKETS; ++b) {
+                out.api[i].hist[b] = api_[i].hist[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> total_ns{ 0 };
+        std::atomic<uint64_t> hist[L1_STATS_BUCKETS] = {};
+    };
+
+    Counters api_[L1_API_COUNT];
+    std::atomic<uint64_t> loads_{ 0 };
+    std::atomic<uint64_t> load_failures_{ 0 };
+};
+
+// Adds the lifetime of the enclosing scope to a counter
+class L1StatsTimer {
+public:
+    explicit L1StatsTimer(uint64_t& sink) : sink_(&sink), start_(std::chrono::steady_clock::now()) {}
+    L1StatsTimer(L1StatsRecorder& rec, L1Api api) : rec_(&rec), api_(api), start_(std::chrono::steady_clock::now()) {}
+    ~L1StatsTimer() {
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        if (rec_) rec_->record(api_, ns);
+        else *sink_ += ns;
+    }
+
+private:
+    L1StatsRecorder* rec_ = nullptr;
+    L1Api api_ = L1Api::Count;
+    uint64_t* sink_ = nullptr;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#define L1_STATS_CAT2(a, b) a##b
+#define L1_STATS_CAT(a, b) L1_STATS_CAT2(a, b)
+// Time the rest of the scope as one call of api
+#define L1_STAT_CALL(recorder, api) L1StatsTimer L1_STATS_CAT(l1_stat_, __LINE__)((recorder), (api))
+// Time the rest of the scope into a load phase of an L1LoadStats
+#define L1_STAT_PHASE(load_stats, phase) \
+    L1StatsTimer L1_STATS_CAT(l1_stat_, __LINE__)((load_stats).phase_ns[(size_t)(phase)])
+// Statement that only exists in instrumented builds
+#define L1_STAT(...) do { __VA_ARGS__; } while (0)
+
+#else
+
+#define L1_STAT_CALL(recorder, api) ((void)(api))
+#define L1_STAT_PHASE(load_stats, phase) do {} while (0)
+#define L1_STAT(...) do {} while (0)
+
+#endif
@@ -1,10 +1,35 @@
 #include "l1parser.h"
 #include "l1parser.hpp"
+#include "l1dat.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 
 // The extern "C" struct definition
 struct L1Context {
     L1Parser inner;
+    // Profile answered locally; only the default one may use the image
+    std::string path = L1_DAT_PATH;
+    // Set when a resident daemon answered at init. inner is then only loaded
+    // once a query has to be answered locally.
+    std::unique_ptr<L1Client> remote;
+    bool loaded = false;
+
+    // Snapshot behind the borrowed (_ref) results, kept until l1_refresh()
+    std::shared_ptr<const L1Snapshot> pinned;
+
+    L1Parser* local() {
+        if (!loaded) loaded = inner.load(path, path == L1_DAT_PATH);
+        return loaded ? &inner : nullptr;
+    }
+
+    const L1Snapshot* borrowed() {
+        if (!pinned) {
+            L1Parser* p = local();
+            if (p) pinned = p->snapshot();
+        }
+        return pinned.get();
+    }
 };
 
 // Helper to return malloc'd string for C API
@@ -35,14 +60,152 @@ static char** vector_to_c_array(const std::vector<std::string>& vec, size_t* cou
     return arr;
 }
 
+// Ask the daemon. nullopt means "answer locally": no daemon, an argument the
+// line protocol cannot carry, or a broken connection (which is dropped).
+static std::optional<L1Reply> ask_remote(L1Context* ctx, const std::vector<std::string_view>& args) {
+    if (!ctx->remote) return std::nullopt;
+    auto line = L1Client::encode(args);
+    if (!line) return std::nullopt;
+    auto reply = ctx->remote->query(*line);
+    if (!reply) ctx->remote.reset();
+    return reply;
+}
+
+template <typename Local>
+static std::optional<std::string> lookup(L1Context* ctx, const std::vector<std::string_view>& cmd, Local local) {
+    if (auto reply = ask_remote(ctx, cmd)) {
+        if (reply->status == L1Status::Ok) return reply->value;
+        return std::nullopt;
+    }
+    L1Parser* p = ctx->local();
+    return p ? local(*p) : std::nullopt;
+}
+
+template <typename Local>
+static std::vector<std::string> lookup_list(L1Context* ctx, const std::vector<std::string_view>& cmd, Local local) {
+    if (auto reply = ask_remote(ctx, cmd)) {
+        std::vector<std::string> vec;
+        if (reply->status != L1Status::Ok) return vec;
+        // List replies are space separated, names never contain whitespace
+        size_t pos = 0;
+        while (pos < reply->value.size()) {
+            size_t end = reply->value.find(' ', pos);
+            if (end == std::string::npos) end = reply->value.size();
+            if (end > pos) vec.push_back(reply->value.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        return vec;
+    }
+    L1Parser* p = ctx->local();
+    return p ? local(*p) : std::vector<std::string>();
+}
+
+static std::string_view safe_sv(const char* s) {
+    return s ? std::string_view(s) : std::string_view();
+}
+
+// Interned and image strings are NUL-terminated, the view is a C string
+static const char* ret_ref(std::optional<std::string_view> v) {
+    return v ? v->data() : nullptr;
+}
+
+// snprintf-style copy: returns the full length, -1 when there is no value
+static int ret_buf(std::optional<std::string_view> v, char* buf, size_t len) {
+    if (!v) return -1;
+    if (len > 0) {
+        size_t n = std::min(v->size(), len - 1);
+        memcpy(buf, v->data(), n);
+        buf[n] = '\0';
+    }
+    return (int)v->size();
+}
+
+// Copy a result out of the current snapshot. Pinning it is a reference
+// count bump, nothing is allocated.
+template <typename Lookup>
+static int lookup_buf(L1Context* ctx, L1Api api, char* buf, size_t len, Lookup lookup) {
+    if (!ctx || (!buf && len)) return -1;
+    L1_STAT_CALL(ctx->inner.stats_recorder(), api);
+    try {
+        L1Parser* p = ctx->local();
+        if (!p) return -1;
+        auto snap = p->snapshot();
+        return ret_buf(lookup(*snap), buf, len);
+    } catch (...) {
+        return -1;
+    }
+}
+
+// Borrowed value out of the pinned snapshot, nullptr when absent
+template <typename Lookup>
+static const char* value_ref(L1Context* ctx, L1Api api, Lookup lookup) {
+    if (!ctx) return nullptr;
+    L1_STAT_CALL(ctx->inner.stats_recorder(), api);
+    try {
+        const L1Snapshot* s = ctx->borrowed();
+        return s ? ret_ref(lookup(*s)) : nullptr;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+// Copy up to max borrowed names of a relation list into out
+template <typename Relation>
+static size_t relation_ref(L1Context* ctx, L1Api api, const char* key, const char** out, size_t max, Relation rel) {
+    if (!ctx || !key || (!out && max)) return 0;
+    L1_STAT_CALL(ctx->inner.stats_recorder(), api);
+    try {
+        const L1Snapshot* s = ctx->borrowed();
+        if (!s) return 0;
+        const auto& names = rel(*s, std::string_view(key));
+        for (size_t i = 0; i < names.size() && i < max; ++i) out[i] = names[i].data();
+        return names.size();
+    } catch (...) {
+        return 0;
+    }
+}
+
+// l1_init() and l1_init_with_arena()
+static L1Context* init_default(void* arena, size_t arena_size) {
+    try {
+        auto* ctx = new (std::nothrow) L1Context();
+        if (!ctx) return nullptr;
+        if (arena) ctx->inner.set_arena(arena, arena_size);
+
+        // Prefer a resident daemon, no file I/O at all on the query path
+        ctx->remote = L1Client::connect();
+        if (ctx->remote) return ctx;
+
+        if (!ctx->local()) {
+            delete ctx;
+            return nullptr;
+        }
+        return ctx;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
 extern "C" {
 
 L1Context* l1_init() {
+    return init_default(nullptr, 0);
+}
+
+L1Context* l1_init_with_arena(void* buf, size_t size) {
+    if (!buf || size == 0) return nullptr;
+    return init_default(buf, size);
+}
+
+L1Context* l1_init_file(const char* path) {
+    if (!path) return nullptr;
     try {
         auto* ctx = new (std::nothrow) L1Context();
         if (!ctx) return nullptr;
-        
-        if (!ctx->inner.load(L1_DAT_PATH)) {
+
+        // Never the daemon, it serves the default profile
+        ctx->path = path;
+        if (!ctx->local()) {
             delete ctx;
             return nullptr;
         }
@@ -52,6 +215,85 @@ L1Context* l1_init() {
     }
 }
 
+int l1_watch(L1Context* ctx) {
+    if (!ctx) return -1;
+    try {
+        // The daemon watches the profile itself
+        if (ctx->remote && !ctx->loaded) return 0;
+        L1Parser* p = ctx->local();
+        return (p && p->watch()) ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int l1_set(L1Context* ctx, const char* dev, const char* key, const char* value) {
+    if (!ctx || !dev || !key || !value) return -1;
+    try {
+        L1Parser* p = ctx->local();
+        return (p && p->set_prop(dev, key, value)) ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int l1_dat_set(L1Context* ctx, const char* ifname, const char* key, const char* value) {
+    if (!ctx || !ifname || !key || !value) return -1;
+    try {
+        L1Parser* p = ctx->local();
+        return (p && p->set_dat(ifname, key, value)) ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int l1_commit(L1Context* ctx) {
+    if (!ctx) return -1;
+    try {
+        // Read our own writes, the daemon only catches up once it reloads
+        ctx->remote.reset();
+        L1Parser* p = ctx->local();
+        return (p && p->commit()) ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+void l1_discard(L1Context* ctx) {
+    if (ctx) ctx->inner.discard();
+}
+
+char* l1_reload(L1Context* ctx) {
+    if (!ctx) return nullptr;
+    try {
+        // The caller asked about this file revision, not the daemon's
+        ctx->remote.reset();
+        L1Parser* p = ctx->local();
+        L1Diff diff;
+        if (!p || !p->reload(&diff)) return nullptr;
+        return strdup(diff.to_json().c_str());
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+int l1_set_if_limits(L1Context* ctx, unsigned int ext, unsigned int apcli, unsigned int wds, unsigned int mesh) {
+    if (!ctx) return -1;
+    try {
+        L1IfLimits limits;
+        limits.ext = ext;
+        limits.apcli = apcli;
+        limits.wds = wds;
+        limits.mesh = mesh;
+        // The daemon resolves names with its own limits
+        ctx->remote.reset();
+        if (!ctx->inner.set_if_limits(limits)) return -1;
+        return ctx->local() ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
 void l1_free(L1Context* ctx) {
     if (ctx) {
         delete ctx;
@@ -68,58 +310,328 @@ void l1_free_str_array(char** arr, size_t count) {
 
 char* l1_get(L1Context* ctx, const char* dev, const char* key) {
     if (!ctx) return nullptr;
-    return L1_GUARD(ret_str(ctx->inner.get_prop(safe_str(dev), safe_str(key))));
+    return L1_GUARD(ret_str(lookup(ctx, { "get", safe_sv(dev), safe_sv(key) },
+        [&](L1Parser& p) { return p.get_prop(safe_str(dev), safe_str(key)); })));
 }
 
 char** l1_list(L1Context* ctx, size_t* count) {
     if (!ctx || !count) return nullptr;
-    return L1_GUARD(vector_to_c_array(ctx->inner.list_devs(), count));
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "list" },
+        [&](L1Parser& p) { return p.list_devs(); }), count));
 }
 
 char* l1_if2zone(L1Context* ctx, const char* ifname) {
     if (!ctx) return nullptr;
-    return L1_GUARD(ret_str(ctx->inner.if2zone(safe_str(ifname))));
+    return L1_GUARD(ret_str(lookup(ctx, { "if2zone", safe_sv(ifname) },
+        [&](L1Parser& p) { return p.if2zone(safe_str(ifname)); })));
 }
 
 char* l1_if2dat(L1Context* ctx, const char* ifname) {
     if (!ctx) return nullptr;
-    return L1_GUARD(ret_str(ctx->inner.if2dat(safe_str(ifname))));
+    return L1_GUARD(ret_str(lookup(ctx, { "if2dat", safe_sv(ifname) },
+        [&](L1Parser& p) { return p.if2dat(safe_str(ifname)); })));
+}
+
+char* l1_dat_get(L1Context* ctx, const char* ifname, const char* key) {
+    if (!ctx) return nullptr;
+    return L1_GUARD(ret_str(lookup(ctx, { "datget", safe_sv(ifname), safe_sv(key) },
+        [&](L1Parser& p) { return p.dat_get(safe_str(ifname), safe_str(key)); })));
+}
+
+// Values of a .dat file come out of its cached index, NUL-terminated
+static char* dat_file_get(const char* dat_path, const char* key) {
+    auto dat = L1DatCache::instance().get(dat_path);
+    auto val = dat ? dat->get(safe_sv(key)) : std::nullopt;
+    return val ? strdup(val->data()) : nullptr;
+}
+
+char* l1_dat_get_file(L1Context* ctx, const char* dat_path, const char* key) {
+    if (!ctx || !dat_path) return nullptr;
+    return L1_GUARD(dat_file_get(dat_path, key));
 }
 
 char** l1_zone2if(L1Context* ctx, const char* zone, size_t* count) {
     if (!ctx || !count || !zone) return nullptr;
-    return L1_GUARD(vector_to_c_array(ctx->inner.zone2if(safe_str(zone)), count));
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "zone2if", safe_sv(zone) },
+        [&](L1Parser& p) { return p.zone2if(safe_str(zone)); }), count));
+}
+
+char** l1_zone2devs(L1Context* ctx, const char* zone, size_t* count) {
+    if (!ctx || !count || !zone) return nullptr;
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "zone2devs", safe_sv(zone) },
+        [&](L1Parser& p) { return p.zone2devs(safe_str(zone)); }), count));
+}
+
+char** l1_zone2ifs(L1Context* ctx, const char* zone, size_t* count) {
+    if (!ctx || !count || !zone) return nullptr;
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "zone2ifs", safe_sv(zone) },
+        [&](L1Parser& p) { return p.zone2ifs(safe_str(zone)); }), count));
+}
+
+char** l1_dat2ifs(L1Context* ctx, const char* dat_path, size_t* count) {
+    if (!ctx || !count || !dat_path) return nullptr;
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "dat2ifs", safe_sv(dat_path) },
+        [&](L1Parser& p) { return p.dat2ifs(safe_str(dat_path)); }), count));
+}
+
+char** l1_dev2ifs(L1Context* ctx, const char* dev, size_t* count) {
+    if (!ctx || !count || !dev) return nullptr;
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "dev2ifs", safe_sv(dev) },
+        [&](L1Parser& p) { return p.dev2ifs(safe_str(dev)); }), count));
 }
 
 char* l1_if2dbdcidx(L1Context* ctx, const char* ifname) {
     if (!ctx) return nullptr;
-    return L1_GUARD(ret_str(ctx->inner.if2dbdcidx(safe_str(ifname))));
+    return L1_GUARD(ret_str(lookup(ctx, { "if2dbdcidx", safe_sv(ifname) },
+        [&](L1Parser& p) { return p.if2dbdcidx(safe_str(ifname)); })));
 }
 
 char* l1_idx2if(L1Context* ctx, size_t idx) {
     if (!ctx) return nullptr;
-    return L1_GUARD(ret_str(ctx->inner.idx2if(idx)));
+    std::string idx_str = std::to_string(idx);
+    return L1_GUARD(ret_str(lookup(ctx, { "idx2if", idx_str },
+        [&](L1Parser& p) { return p.idx2if(idx); })));
 }
 
-/* C API for libiwinfo */
-char* l1_get_chip_id_by_devname(L1Context* ctx, const char* dev) {
-    if (!ctx) return nullptr;
-    return L1_GUARD(ret_str(ctx->inner.get_prop(safe_str(dev), "INDEX")));
+char** l1_idx_table(L1Context* ctx, size_t* count) {
+    if (!ctx || !count) return nullptr;
+    return L1_GUARD(vector_to_c_array(lookup_list(ctx, { "idxtable" },
+        [&](L1Parser& p) { return p.idx_table(); }), count));
 }
 
-char* l1_get_chip_id_by_ifname(L1Context* ctx, const char* ifname) {
+size_t l1_if2idx(L1Context* ctx, const char* ifname) {
+    if (!ctx || !ifname) return 0;
     try {
-        if (!ctx) return nullptr;
-        const auto& map = ctx->inner.get_if_map();
-        auto it = map.find(safe_str(ifname));
-        if (it != map.end()) {
-            auto pit = it->second.props.find("INDEX");
-            if (pit != it->second.props.end()) {
-                return strdup(pit->second.c_str());
+        auto res = lookup(ctx, { "if2idx", safe_sv(ifname) }, [&](L1Parser& p) -> std::optional<std::string> {
+            auto idx = p.if2idx(ifname);
+            if (idx) return std::to_string(*idx);
+            return std::nullopt;
+        });
+        return res ? std::stoul(*res) : 0;
+    } catch (...) {
+        return 0;
+    }
+}
+
+char** l1_query_batch(L1Context* ctx, const char* const* queries, size_t count) {
+    if (!ctx || !queries || count == 0) return nullptr;
+    try {
+        std::vector<L1Reply> replies;
+        std::vector<std::string> lines;
+        for (size_t i = 0; i < count; ++i) {
+            lines.emplace_back(queries[i] ? queries[i] : "");
+        }
+
+        // Pipeline the whole batch to the daemon in one round trip
+        if (ctx->remote && std::none_of(lines.begin(), lines.end(),
+                                        [](const std::string& l) { return l.find('\n') != std::string::npos; })) {
+            if (auto res = ctx->remote->query(lines)) replies = std::move(*res);
+            else ctx->remote.reset();
+        }
+        if (replies.empty()) {
+            L1Parser* p = ctx->local();
+            if (!p) return nullptr;
+            // One snapshot for the whole batch, a reload cannot split it
+            auto snap = p->snapshot();
+            for (const auto& line : lines) {
+                L1_STAT_CALL(p->stats_recorder(), L1Api::query);
+                replies.push_back(snap->query(std::string_view(line)));
             }
         }
-        return nullptr;
+
+        size_t str_bytes = 0;
+        for (const auto& r : replies) {
+            if (r.status == L1Status::Ok) str_bytes += r.value.size() + 1;
+        }
+
+        // Layout: char* table followed by the NUL-terminated answers
+        char** arr = (char**)malloc(sizeof(char*) * count + str_bytes);
+        if (!arr) return nullptr;
+
+        char* p = reinterpret_cast<char*>(arr + count);
+        for (size_t i = 0; i < count; ++i) {
+            if (replies[i].status != L1Status::Ok) {
+                arr[i] = nullptr;
+                continue;
+            }
+            const std::string& v = replies[i].value;
+            memcpy(p, v.c_str(), v.size() + 1);
+            arr[i] = p;
+            p += v.size() + 1;
+        }
+        return arr;
     } catch (...) { return nullptr; }
 }
 
+char* l1_stats(L1Context* ctx) {
+    if (!ctx) return nullptr;
+    return L1_GUARD(strdup(l1_stats_json(ctx->inner.stats()).c_str()));
+}
+
+char* l1_memory_usage(L1Context* ctx) {
+    if (!ctx) return nullptr;
+    return L1_GUARD(strdup(l1_mem_json(ctx->inner.memory_usage()).c_str()));
+}
+
+int l1_set_compact(L1Context* ctx, int compact) {
+    if (!ctx) return -1;
+    try {
+        return ctx->inner.set_compact(compact != 0) ? 0 : -1;
+    } catch (...) {
+        return -1;
+    }
+}
+
+int l1_refresh(L1Context* ctx) {
+    if (!ctx) return -1;
+    try {
+        L1Parser* p = ctx->local();
+        if (!p) return -1;
+        ctx->pinned = p->snapshot();
+        return 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
+const char* l1_get_ref(L1Context* ctx, const char* dev, const char* key) {
+    return value_ref(ctx, L1Api::get_prop, [&](const L1Snapshot& s) { return s.prop_view(safe_sv(dev), safe_sv(key)); });
+}
+
+const char* l1_if2zone_ref(L1Context* ctx, const char* ifname) {
+    return value_ref(ctx, L1Api::if2zone, [&](const L1Snapshot& s) { return s.if_prop_view(safe_sv(ifname), L1Key::nvram_zone); });
+}
+
+const char* l1_if2dat_ref(L1Context* ctx, const char* ifname) {
+    return value_ref(ctx, L1Api::if2dat, [&](const L1Snapshot& s) { return s.if_prop_view(safe_sv(ifname), L1Key::profile_path); });
+}
+
+const char* l1_idx2if_ref(L1Context* ctx, size_t idx) {
+    return value_ref(ctx, L1Api::idx2if, [&](const L1Snapshot& s) { return s.idx2if_view(idx); });
+}
+
+const char* l1_get_chip_id_by_devname_ref(L1Context* ctx, const char* dev) {
+    return value_ref(ctx, L1Api::get_prop, [&](const L1Snapshot& s) { return s.prop_view(safe_sv(dev), L1Key::INDEX); });
+}
+
+const char* l1_get_chip_id_by_ifname_ref(L1Context* ctx, const char* ifname) {
+    return value_ref(ctx, L1Api::get_if_prop, [&](const L1Snapshot& s) { return s.if_prop_view(safe_sv(ifname), L1Key::INDEX); });
+}
+
+size_t l1_list_ref(L1Context* ctx, const char** out, size_t max) {
+    if (!ctx || (!out && max)) return 0;
+    L1_STAT_CALL(ctx->inner.stats_recorder(), L1Api::list_devs);
+    try {
+        const L1Snapshot* s = ctx->borrowed();
+        if (!s) return 0;
+        size_t n = s->dev_count();
+        for (size_t i = 0; i < n && i < max; ++i) out[i] = s->dev_key(i).data();
+        return n;
+    } catch (...) {
+        return 0;
+    }
+}
+
+size_t l1_idx_table_ref(L1Context* ctx, const char** out, size_t max) {
+    if (!ctx || (!out && max)) return 0;
+    L1_STAT_CALL(ctx->inner.stats_recorder(), L1Api::idx_table);
+    try {
+        const L1Snapshot* s = ctx->borrowed();
+        if (!s) return 0;
+        size_t n = s->seq_count();
+        for (size_t i = 0; i < n && i < max; ++i) out[i] = s->seq_if(i).data();
+        return n;
+    } catch (...) {
+        return 0;
+    }
+}
+
+size_t l1_zone2if_ref(L1Context* ctx, const char* zone, const char** out, size_t max) {
+    if (!ctx || !zone || (!out && max)) return 0;
+    L1_STAT_CALL(ctx->inner.stats_recorder(), L1Api::zone2if);
+    try {
+        const L1Snapshot* s = ctx->borrowed();
+        if (!s) return 0;
+        std::string_view views[std::size(L1_IF_KEYS)];
+        size_t n = s->zone2if_views(zone, views, std::size(views));
+        for (size_t i = 0; i < n && i < max; ++i) out[i] = views[i].data();
+        return n;
+    } catch (...) {
+        return 0;
+    }
+}
+
+size_t l1_zone2devs_ref(L1Context* ctx, const char* zone, const char** out, size_t max) {
+    return relation_ref(ctx, L1Api::zone2devs, zone, out, max, [](const L1Snapshot& s, std::string_view k) -> const auto& { return s.zone2devs(k); });
+}
+
+size_t l1_zone2ifs_ref(L1Context* ctx, const char* zone, const char** out, size_t max) {
+    return relation_ref(ctx, L1Api::zone2ifs, zone, out, max, [](const L1Snapshot& s, std::string_view k) -> const auto& { return s.zone2ifs(k); });
+}
+
+size_t l1_dat2ifs_ref(L1Context* ctx, const char* dat_path, const char** out, size_t max) {
+    return relation_ref(ctx, L1Api::dat2ifs, dat_path, out, max, [](const L1Snapshot& s, std::string_view k) -> const auto& { return s.dat2ifs(k); });
+}
+
+size_t l1_dev2ifs_ref(L1Context* ctx, const char* dev, const char** out, size_t max) {
+    return relation_ref(ctx, L1Api::dev2ifs, dev, out, max, [](const L1Snapshot& s, std::string_view k) -> const auto& { return s.dev2ifs(k); });
+}
+
+int l1_get_r(L1Context* ctx, const char* dev, const char* key, char* buf, size_t len) {
+    return lookup_buf(ctx, L1Api::get_prop, buf, len, [&](const L1Snapshot& s) { return s.prop_view(safe_sv(dev), safe_sv(key)); });
+}
+
+int l1_if2zone_r(L1Context* ctx, const char* ifname, char* buf, size_t len) {
+    return lookup_buf(ctx, L1Api::if2zone, buf, len, [&](const L1Snapshot& s) { return s.if_prop_view(safe_sv(ifname), L1Key::nvram_zone); });
+}
+
+int l1_if2dat_r(L1Context* ctx, const char* ifname, char* buf, size_t len) {
+    return lookup_buf(ctx, L1Api::if2dat, buf, len, [&](const L1Snapshot& s) { return s.if_prop_view(safe_sv(ifname), L1Key::profile_path); });
+}
+
+int l1_dat_get_r(L1Context* ctx, const char* ifname, const char* key, char* buf, size_t len) {
+    // Holds the index until the value is copied out
+    std::shared_ptr<const L1DatFile> dat;
+    return lookup_buf(ctx, L1Api::dat_get, buf, len, [&](const L1Snapshot& s) -> std::optional<std::string_view> {
+        auto path = s.if_prop_view(safe_sv(ifname), L1Key::profile_path);
+        if (!path || path->empty()) return std::nullopt;
+        dat = L1DatCache::instance().get(*path);
+        return dat ? dat->get(safe_sv(key)) : std::nullopt;
+    });
+}
+
+int l1_idx2if_r(L1Context* ctx, size_t idx, char* buf, size_t len) {
+    return lookup_buf(ctx, L1Api::idx2if, buf, len, [&](const L1Snapshot& s) { return s.idx2if_view(idx); });
+}
+
+int l1_if2dbdcidx_r(L1Context* ctx, const char* ifname, char* buf, size_t len) {
+    char num[24];
+    return lookup_buf(ctx, L1Api::if2dbdcidx, buf, len, [&](const L1Snapshot& s) -> std::optional<std::string_view> {
+        auto idx = s.if_sub_idx(safe_sv(ifname));
+        if (!idx) return std::nullopt;
+        return std::string_view(num, (size_t)snprintf(num, sizeof(num), "%zu", *idx));
+    });
+}
+
+int l1_get_chip_id_by_devname_r(L1Context* ctx, const char* dev, char* buf, size_t len) {
+    return lookup_buf(ctx, L1Api::get_prop, buf, len, [&](const L1Snapshot& s) { return s.prop_view(safe_sv(dev), L1Key::INDEX); });
+}
+
+int l1_get_chip_id_by_ifname_r(L1Context* ctx, const char* ifname, char* buf, size_t len) {
+    return lookup_buf(ctx, L1Api::get_if_prop, buf, len, [&](const L1Snapshot& s) { return s.if_prop_view(safe_sv(ifname), L1Key::INDEX); });
+}
+
+/* C API for libiwinfo */
+char* l1_get_chip_id_by_devname(L1Context* ctx, const char* dev) {
+    if (!ctx) return nullptr;
+    return L1_GUARD(ret_str(lookup(ctx, { "get", safe_sv(dev), "INDEX" },
+        [&](L1Parser& p) { return p.get_prop(safe_str(dev), "INDEX"); })));
+}
+
+char* l1_get_chip_id_by_ifname(L1Context* ctx, const char* ifname) {
+    if (!ctx) return nullptr;
+    return L1_GUARD(ret_str(lookup(ctx, { "getif", safe_sv(ifname), "INDEX" },
+        [&](L1Parser& p) { return p.get_if_prop(safe_str(ifname), "INDEX"); })));
+}
+
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "l1parser.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A wedged daemon must not hang callers, they fall back to parsing locally
+static const int L1_CLIENT_TIMEOUT_SEC = 2;
+
+L1Client::~L1Client() {
+    if (fd_ >= 0) close(fd_);
+}
+
+std::unique_ptr<L1Client> L1Client::connect(const std::string& sock_path) {
+    struct sockaddr_un addr;
+    if (sock_path.size() >= sizeof(addr.sun_path)) return nullptr;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return nullptr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, sock_path.c_str(), sock_path.size());
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    struct timeval tv = { L1_CLIENT_TIMEOUT_SEC, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    return std::unique_ptr<L1Client>(new L1Client(fd));
+}
+
+std::optional<std::string> L1Client::encode(const std::vector<std::string_view>& args) {
+    std::string line;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i].empty() || args[i].find_first_of(" \t\r\n") != std::string_view::npos) return std::nullopt;
+        if (i) line += ' ';
+        line.append(args[i].data(), args[i].size());
+    }
+    return line;
+}
+
+bool L1Client::send_all(const std::string& data) {
+    const char* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = send(fd_, p, left, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+    return true;
+}
+
+bool L1Client::read_line(std::string& line) {
+    for (;;) {
+        size_t nl = rbuf_.find('\n');
+        if (nl != std::string::npos) {
+            line.assign(rbuf_, 0, nl);
+            rbuf_.erase(0, nl + 1);
+            return true;
+        }
+
+        char buf[4096];
+        ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        rbuf_.append(buf, (size_t)n);
+    }
+}
+
+std::optional<L1Reply> L1Client::query(std::string_view line) {
+    std::string req(line);
+    req += '\n';
+    std::string resp;
+    if (!send_all(req) || !read_line(resp)) return std::nullopt;
+    return L1Reply::from_line(resp);
+}
+
+std::optional<std::vector<L1Reply>> L1Client::query(const std::vector<std::string>& lines) {
+    std::string req;
+    for (const auto& line : lines) {
+        req += line;
+        req += '\n';
+    }
+    if (!send_all(req)) return std::nullopt;
+
+    std::vector<L1Reply> replies;
+    replies.reserve(lines.size());
+    std::string resp;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (!read_line(resp)) return std::nullopt;
+        replies.push_back(L1Reply::from_line(resp));
+    }
+    return replies;
+}
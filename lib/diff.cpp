@@ -0,0 +1,111 @@
+#include "l1parser.hpp"
+#include "../utils/json.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+/*
+ * Snapshot comparison for L1Parser::reload(). Both snapshots stay pinned by
+ * the caller, so everything is compared as views and only the names that
+ * end up in the L1Diff are copied.
+ */
+
+namespace {
+
+using Props = std::vector<std::pair<std::string_view, std::string_view>>;
+
+// Keys present on one side only or with different values, sorted
+std::vector<std::string> changed_keys(const Props& pa, const Props& pb) {
+    std::vector<std::string> keys;
+    size_t i = 0, j = 0;
+    while (i < pa.size() || j < pb.size()) {
+        if (j == pb.size() || (i < pa.size() && pa[i].first < pb[j].first)) {
+            keys.emplace_back(pa[i++].first);
+        } else if (i == pa.size() || pb[j].first < pa[i].first) {
+            keys.emplace_back(pb[j++].first);
+        } else {
+            if (pa[i].second != pb[j].second) keys.emplace_back(pa[i].first);
+            ++i, ++j;
+        }
+    }
+    return keys;
+}
+
+void put_json_list(std::string& out, const std::vector<std::string>& list) {
+    out += '[';
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (i) out += ", ";
+        utils::append_json_string(out, list[i]);
+    }
+    out += ']';
+}
+
+} // namespace
+
+L1Diff L1Snapshot::diff(const L1Snapshot& older) const {
+    L1Diff d;
+    // Properties are read in place on both sides, image or parsed
+    Props cur, old;
+
+    std::unordered_set<std::string_view> modified;
+    for (size_t i = 0; i < dev_count(); ++i) {
+        std::string_view dev = dev_key(i);
+        if (!older.sorted_props(dev, old)) {
+            d.devs_added.emplace_back(dev);
+            continue;
+        }
+        sorted_props(dev, cur);
+        auto keys = changed_keys(old, cur);
+        if (keys.empty()) continue;
+        modified.insert(dev);
+        d.devs_modified.emplace_back(std::string(dev), std::move(keys));
+    }
+    for (size_t i = 0; i < older.dev_count(); ++i) {
+        std::string_view dev = older.dev_key(i);
+        // Every device has its INDEX
+        if (!prop_view(dev, L1Key::INDEX)) d.devs_removed.emplace_back(dev);
+    }
+
+    // Interface name -> owning device on each side
+    std::unordered_map<std::string_view, std::string_view> old_owner;
+    for (size_t i = 0; i < older.dev_count(); ++i) {
+        for (std::string_view name : older.dev2ifs(older.dev_key(i))) old_owner.emplace(name, older.dev_key(i));
+    }
+    std::unordered_set<std::string_view> seen;
+    for (size_t i = 0; i < dev_count(); ++i) {
+        std::string_view dev = dev_key(i);
+        for (std::string_view name : dev2ifs(dev)) {
+            seen.insert(name);
+            auto it = old_owner.find(name);
+            if (it == old_owner.end()) d.ifs_added.emplace_back(name);
+            else if (it->second != dev || modified.count(dev)) d.ifs_modified.emplace_back(name);
+        }
+    }
+    for (size_t i = 0; i < older.dev_count(); ++i) {
+        for (std::string_view name : older.dev2ifs(older.dev_key(i))) {
+            if (!seen.count(name)) d.ifs_removed.emplace_back(name);
+        }
+    }
+    return d;
+}
+
+std::string L1Diff::to_json() const {
+    std::string out = "{\"devices\": {\"added\": ";
+    put_json_list(out, devs_added);
+    out += ", \"removed\": ";
+    put_json_list(out, devs_removed);
+    out += ", \"modified\": {";
+    for (size_t i = 0; i < devs_modified.size(); ++i) {
+        if (i) out += ", ";
+        utils::append_json_string(out, devs_modified[i].first);
+        out += ": ";
+        put_json_list(out, devs_modified[i].second);
+    }
+    out += "}}, \"interfaces\": {\"added\": ";
+    put_json_list(out, ifs_added);
+    out += ", \"removed\": ";
+    put_json_list(out, ifs_removed);
+    out += ", \"modified\": ";
+    put_json_list(out, ifs_modified);
+    out += "}}";
+    return out;
+}
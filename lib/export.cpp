@@ -0,0 +1,260 @@
+#include "l1parser.hpp"
+#include "../utils/json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <unordered_set>
+#include <unistd.h>
+
+/*
+ * Whole-profile export (`l1util export`). Every name and value is a view into
+ * the snapshot and goes straight into one output buffer, escaped run by run;
+ * nothing is copied into intermediate strings (shell names aside, which are
+ * collected once to check that they stay distinct).
+ *
+ *   kv     dev.<dev>.<key>=<value>, if.<ifname>=<dev>, idx.<n>=<ifname>
+ *   shell  L1_DEVS, L1_DEV_<dev>_<key>, L1_IFS, L1_IF_<ifname>, L1_IDX_<n>,
+ *          L1_IDX_COUNT; single-quoted, names with [^A-Za-z0-9_] mapped to '_'.
+ *          Fails with EEXIST, before writing anything, when two names map
+ *          to the same variable (e.g. keys "a-b" and "a_b").
+ *   json   {"devices": {dev: {key: value}}, "interfaces": {ifname: dev},
+ *           "idx": [ifname...]}
+ *
+ * Devices come in list_devs() order with their properties sorted by key,
+ * interfaces grouped per device in dev2ifs() order, idx in idx2if() order.
+ */
+
+namespace {
+
+// Shell variable names keep [A-Za-z0-9_]
+char shell_char(char c) {
+    return isalnum((unsigned char)c) ? c : '_';
+}
+
+class FdWriter {
+public:
+    explicit FdWriter(int fd) : fd_(fd) {}
+
+    void put(char c) {
+        if (len_ == sizeof(buf_)) flush();
+        buf_[len_++] = c;
+    }
+
+    void put(std::string_view s) {
+        while (!s.empty()) {
+            if (len_ == sizeof(buf_)) flush();
+            size_t n = std::min(s.size(), sizeof(buf_) - len_);
+            memcpy(buf_ + len_, s.data(), n);
+            len_ += n;
+            s.remove_prefix(n);
+        }
+    }
+
+    void put_num(size_t v) {
+        char num[24];
+        size_t n = 0;
+        do {
+            num[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (n) put(num[--n]);
+    }
+
+    // '...' with embedded quotes as '\''
+    void put_shell_quoted(std::string_view s) {
+        put('\'');
+        size_t q;
+        while ((q = s.find('\'')) != std::string_view::npos) {
+            put(s.substr(0, q));
+            put("'\\''");
+            s.remove_prefix(q + 1);
+        }
+        put(s);
+        put('\'');
+    }
+
+    void put_shell_name(std::string_view s) {
+        for (char c : s) put(shell_char(c));
+    }
+
+    void put_json_string(std::string_view s) {
+        utils::put_json_string(s, [this](std::string_view part) { put(part); });
+    }
+
+    bool flush() {
+        size_t off = 0;
+        while (ok_ && off < len_) {
+            ssize_t n = write(fd_, buf_ + off, len_ - off);
+            if (n > 0) off += (size_t)n;
+            else if (n < 0 && errno != EINTR) ok_ = false;
+        }
+        len_ = 0;
+        return ok_;
+    }
+
+private:
+    int fd_;
+    bool ok_ = true;
+    size_t len_ = 0;
+    char buf_[64 * 1024];
+};
+
+using Props = std::vector<std::pair<std::string_view, std::string_view>>;
+
+} // namespace
+
+bool L1Snapshot::export_to(int fd, L1ExportFormat format) const {
+    FdWriter w(fd);
+    size_t ndev = dev_count();
+    Props props;
+
+    // Read in place, image or parsed
+    auto dev_props = [&](std::string_view dev) -> const Props& {
+        sorted_props(dev, props);
+        return props;
+    };
+
+    if (format == L1ExportFormat::Kv) {
+        for (size_t d = 0; d < ndev; ++d) {
+            std::string_view dev = dev_key(d);
+            for (const auto& [k, v] : dev_props(dev)) {
+                w.put("dev.");
+                w.put(dev);
+                w.put('.');
+                w.put(k);
+                w.put('=');
+                w.put(v);
+                w.put('\n');
+            }
+        }
+        for (size_t d = 0; d < ndev; ++d) {
+            for (std::string_view name : dev2ifs(dev_key(d))) {
+                w.put("if.");
+                w.put(name);
+                w.put('=');
+                w.put(dev_key(d));
+                w.put('\n');
+            }
+        }
+        for (size_t i = 0; i < seq_count(); ++i) {
+            w.put("idx.");
+            w.put_num(i + 1);
+            w.put('=');
+            w.put(seq_if(i));
+            w.put('\n');
+        }
+    } else if (format == L1ExportFormat::Shell) {
+        // The later of two assignments to one variable would hide the other
+        // without a word; the only copies of names the export makes
+        std::unordered_set<std::string> vars;
+        std::string var;
+        auto add = [&](std::string_view s) {
+            for (char c : s) var += shell_char(c);
+        };
+        for (size_t d = 0; d < ndev; ++d) {
+            std::string_view dev = dev_key(d);
+            for (const auto& kv : dev_props(dev)) {
+                var = "L1_DEV_";
+                add(dev);
+                var += '_';
+                add(kv.first);
+                if (!vars.insert(var).second) {
+                    errno = EEXIST;
+                    return false;
+                }
+            }
+            for (std::string_view name : dev2ifs(dev)) {
+                var = "L1_IF_";
+                add(name);
+                if (!vars.insert(var).second) {
+                    errno = EEXIST;
+                    return false;
+                }
+            }
+        }
+
+        w.put("L1_DEVS='");
+        for (size_t d = 0; d < ndev; ++d) {
+            if (d) w.put(' ');
+            w.put(dev_key(d));
+        }
+        w.put("'\n");
+        for (size_t d = 0; d < ndev; ++d) {
+            std::string_view dev = dev_key(d);
+            for (const auto& [k, v] : dev_props(dev)) {
+                w.put("L1_DEV_");
+                w.put_shell_name(dev);
+                w.put('_');
+                w.put_shell_name(k);
+                w.put('=');
+                w.put_shell_quoted(v);
+                w.put('\n');
+            }
+        }
+        w.put("L1_IFS='");
+        bool first = true;
+        for (size_t d = 0; d < ndev; ++d) {
+            for (std::string_view name : dev2ifs(dev_key(d))) {
+                if (!first) w.put(' ');
+                first = false;
+                w.put(name);
+            }
+        }
+        w.put("'\n");
+        for (size_t d = 0; d < ndev; ++d) {
+            for (std::string_view name : dev2ifs(dev_key(d))) {
+                w.put("L1_IF_");
+                w.put_shell_name(name);
+                w.put('=');
+                w.put_shell_quoted(dev_key(d));
+                w.put('\n');
+            }
+        }
+        for (size_t i = 0; i < seq_count(); ++i) {
+            w.put("L1_IDX_");
+            w.put_num(i + 1);
+            w.put('=');
+            w.put_shell_quoted(seq_if(i));
+            w.put('\n');
+        }
+        w.put("L1_IDX_COUNT=");
+        w.put_num(seq_count());
+        w.put('\n');
+    } else {
+        w.put("{\"devices\": {");
+        for (size_t d = 0; d < ndev; ++d) {
+            std::string_view dev = dev_key(d);
+            if (d) w.put(", ");
+            w.put_json_string(dev);
+            w.put(": {");
+            bool first = true;
+            for (const auto& [k, v] : dev_props(dev)) {
+                if (!first) w.put(", ");
+                first = false;
+                w.put_json_string(k);
+                w.put(": ");
+                w.put_json_string(v);
+            }
+            w.put('}');
+        }
+        w.put("}, \"interfaces\": {");
+        bool first = true;
+        for (size_t d = 0; d < ndev; ++d) {
+            for (std::string_view name : dev2ifs(dev_key(d))) {
+                if (!first) w.put(", ");
+                first = false;
+                w.put_json_string(name);
+                w.put(": ");
+                w.put_json_string(dev_key(d));
+            }
+        }
+        w.put("}, \"idx\": [");
+        for (size_t i = 0; i < seq_count(); ++i) {
+            if (i) w.put(", ");
+            w.put_json_string(seq_if(i));
+        }
+        w.put("]}\n");
+    }
+    return w.flush();
+}
@@ -0,0 +1,120 @@
+#include "l1dat.hpp"
+#include "../utils/fileview.hpp"
+#include "../utils/stringutils.hpp"
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+std::shared_ptr<const L1DatFile> L1DatFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    utils::FileView file;
+    bool ok = fstat(fd, &st) == 0 && file.open(fd, st);
+    close(fd);
+    if (!ok) return nullptr;
+    return parse(file.data(), st);
+}
+
+std::shared_ptr<const L1DatFile> L1DatFile::parse(std::string_view text, const struct stat& st) {
+    std::shared_ptr<L1DatFile> dat(new L1DatFile());
+    dat->st_ = st;
+    // '#' is a legal character in SSIDs and passphrases, only whole lines
+    // are comments here
+    utils::for_each_kv_line(text, false, [&](std::string_view key, std::string_view val) {
+        if (dat->props_.count(key)) return;
+        dat->props_.emplace(dat->pool_.intern(key), dat->pool_.intern(val));
+    });
+    dat->pool_.release_index();
+    return dat;
+}
+
+std::optional<std::string_view> L1DatFile::get(std::string_view key) const {
+    auto it = props_.find(key);
+    if (it == props_.end()) return std::nullopt;
+    return it->second;
+}
+
+bool L1DatFile::same_file(const struct stat& st) const {
+    return st.st_ino == st_.st_ino && st.st_dev == st_.st_dev && st.st_size == st_.st_size &&
+           st.st_mtim.tv_sec == st_.st_mtim.tv_sec && st.st_mtim.tv_nsec == st_.st_mtim.tv_nsec;
+}
+
+L1DatCache& L1DatCache::instance() {
+    static L1DatCache cache;
+    return cache;
+}
+
+L1DatCache::~L1DatCache() {
+    // A watcher joins its thread, whose callback takes mutex_: stop them
+    // outside of it
+    std::map<std::string, File, std::less<>> files;
+    std::lock_guard<std::mutex> lock(mutex_);
+    files.swap(files_);
+}
+
+std::shared_ptr<const L1DatFile> L1DatCache::get(std::string_view path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(path);
+        if (it != files_.end() && it->second.dat) return it->second.dat;
+    }
+
+    // Index outside the lock; two threads racing on the same file both
+    // build it and the later one wins, which is harmless
+    std::string key(path);
+    auto dat = L1DatFile::open(key);
+    if (!dat) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    File& file = files_[key];
+    file.dat = dat;
+    if (watching_ && !file.watcher) watch_file(key, file);
+    return dat;
+}
+
+void L1DatCache::put(const std::string& path, std::string_view text, const struct stat& st) {
+    auto dat = L1DatFile::parse(text, st);
+    std::lock_guard<std::mutex> lock(mutex_);
+    File& file = files_[path];
+    file.dat = std::move(dat);
+    if (watching_ && !file.watcher) watch_file(path, file);
+}
+
+void L1DatCache::revalidate() {
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [path, file] : files_) {
+            if (file.dat) paths.push_back(path);
+        }
+    }
+    for (const auto& path : paths) drop_stale(path);
+}
+
+void L1DatCache::watch() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (watching_) return;
+        watching_ = true;
+        for (auto& [path, file] : files_) watch_file(path, file);
+    }
+    // Whatever changed before the watches started
+    revalidate();
+}
+
+// Caller holds mutex_. Entries are never erased while the cache lives, so
+// the watcher cannot be destroyed from its own callback.
+void L1DatCache::watch_file(const std::string& path, File& file) {
+    // Without inotify the file is still checked at every (re)load
+    file.watcher = L1Watcher::start(path, [this, path]() { drop_stale(path); });
+}
+
+void L1DatCache::drop_stale(const std::string& path) {
+    struct stat st;
+    bool gone = stat(path.c_str(), &st) != 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(path);
+    if (it == files_.end() || !it->second.dat) return;
+    if (gone || !it->second.dat->same_file(st)) it->second.dat.reset();
+}
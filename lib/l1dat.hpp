@@ -0,0 +1,84 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <sys/stat.h>
+#include "l1watch.hpp"
+#include "../utils/strpool.hpp"
+
+/*
+ * Per-band driver profiles, the .dat files profile_path points at.
+ *
+ * A file is read the first time one of its keys is asked for: mapped,
+ * tokenized like l1profile.dat, its pairs interned and the mapping dropped,
+ * so editing or truncating the file later cannot pull data out from under a
+ * reader. Later lookups cost one hash probe and never touch the file: an
+ * index is dropped, and built again on the next lookup, when its file turns
+ * out to have changed (inode, size or mtime) at a (re)load of the profile or,
+ * once a parser watches its profile, as soon as inotify reports the change.
+ * Write-back hands over the text it wrote instead.
+ */
+class L1DatFile {
+public:
+    // nullptr if path cannot be read
+    static std::shared_ptr<const L1DatFile> open(const std::string& path);
+    // Index text, st describing the file it was read from
+    static std::shared_ptr<const L1DatFile> parse(std::string_view text, const struct stat& st);
+
+    // First value of key, as the driver reads it. NUL-terminated.
+    std::optional<std::string_view> get(std::string_view key) const;
+    size_t size() const { return props_.size(); }
+
+    // Whether st still describes the file this index was built from
+    bool same_file(const struct stat& st) const;
+
+private:
+    L1DatFile() = default;
+
+    struct stat st_ = {};
+    utils::StringPool pool_;
+    std::unordered_map<std::string_view, std::string_view> props_;
+};
+
+/*
+ * Indexed .dat files by path. One cache serves the whole process: the files
+ * belong to the system, not to one L1Parser, and a daemon answering for many
+ * clients indexes each of them once.
+ */
+class L1DatCache {
+public:
+    static L1DatCache& instance();
+    ~L1DatCache();
+
+    // Index of path, built if missing or dropped; nullptr if the file cannot
+    // be read. The result stays valid however long it is held. Allocates
+    // nothing unless it has to read the file.
+    std::shared_ptr<const L1DatFile> get(std::string_view path);
+    // Replace the index of path with text just written there (write-back)
+    void put(const std::string& path, std::string_view text, const struct stat& st);
+    // Drop the indexes whose file changed or went away (L1Parser::load())
+    void revalidate();
+    // From now on watch every indexed file and drop its index on a change
+    // (L1Parser::watch()). Stays on, the cache outlives any one parser.
+    void watch();
+
+private:
+    struct File {
+        std::shared_ptr<const L1DatFile> dat;   // null once dropped
+        std::unique_ptr<L1Watcher> watcher;
+    };
+
+    void watch_file(const std::string& path, File& file);
+    // Drop the index of path if its file changed or went away
+    void drop_stale(const std::string& path);
+
+    std::mutex mutex_;
+    bool watching_ = false;
+    // Ordered for lookups by string_view; a process reads a handful of files
+    std::map<std::string, File, std::less<>> files_;
+};
@@ -0,0 +1,413 @@
+#include "l1image.hpp"
+#include "l1parser.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const char L1_IMAGE_MAGIC[8] = { 'L', '1', 'P', 'I', 'M', 'G', 0, 0 };
+
+/* --- Writer --- */
+
+L1ImageStr L1ImageWriter::intern(std::string_view s) {
+    // Identical strings (keys, chip names, empty values) are stored once
+    auto it = str_index_.find(std::string(s));
+    if (it != str_index_.end()) return { it->second, (uint32_t)s.size() };
+
+    uint32_t off = (uint32_t)strings_.size();
+    strings_.append(s.data(), s.size());
+    strings_.push_back('\0');
+    str_index_.emplace(std::string(s), off);
+    return { off, (uint32_t)s.size() };
+}
+
+uint32_t L1ImageWriter::add_dev(std::string_view key, size_t main_idx, size_t sub_idx) {
+    L1ImageDev d;
+    d.key = intern(key);
+    d.main_idx = (uint32_t)main_idx;
+    d.sub_idx = (uint32_t)sub_idx;
+    d.props_begin = (uint32_t)props_.size();
+    d.props_count = 0;
+    d.known_mask = 0;
+    memset(d.known, 0, sizeof(d.known));
+    devs_.push_back(d);
+    return (uint32_t)devs_.size() - 1;
+}
+
+void L1ImageWriter::add_prop(std::string_view key, std::string_view val) {
+    if (devs_.empty()) return;
+    L1ImageDev& d = devs_.back();
+    if (auto k = l1_key(key)) {
+        d.known[(size_t)*k] = intern(val);
+        d.known_mask |= 1u << (unsigned)*k;
+        return;
+    }
+    props_.push_back({ intern(key), intern(val) });
+    d.props_count++;
+}
+
+void L1ImageWriter::add_if_base(std::string_view name, const L1IfRule* rules, const std::string_view* digits, size_t n) {
+    bases_.push_back({ intern(name), (uint32_t)rules_.size(), (uint32_t)n });
+    rules_.insert(rules_.end(), rules, rules + n);
+    for (size_t i = 0; i < n; ++i) digits_.push_back(intern(digits[i]));
+}
+
+void L1ImageWriter::add_seq(std::string_view name) {
+    seq_.push_back(intern(name));
+}
+
+void L1ImageWriter::add_block(size_t raw_idx, uint64_t fp) {
+    blocks_.push_back({ (uint64_t)raw_idx, fp });
+}
+
+std::string L1ImageWriter::build(const std::string& src_path, const struct stat& src_st) {
+    auto sv = [&](const L1ImageStr& s) { return std::string_view(strings_.data() + s.off, s.len); };
+
+    // Lookups binary search these tables, so sort them by their string keys
+    for (auto& d : devs_) {
+        auto first = props_.begin() + d.props_begin;
+        std::sort(first, first + d.props_count,
+                  [&](const L1ImageProp& a, const L1ImageProp& b) { return sv(a.key) < sv(b.key); });
+    }
+    std::sort(bases_.begin(), bases_.end(),
+              [&](const L1ImageBase& a, const L1ImageBase& b) { return sv(a.name) < sv(b.name); });
+
+    // Perfect hashes over the final key sets; on failure readers keep the
+    // binary search (the tables stay sorted either way)
+    auto hash_table = [&](std::vector<std::string_view> keys, utils::PerfectHash& ph, std::vector<uint32_t>& slots) {
+        slots.clear();
+        if (!ph.build(keys) || ph.size() == 0) return;
+        slots.resize(keys.size());
+        for (uint32_t i = 0; i < keys.size(); ++i) slots[ph.slot(keys[i])] = i;
+    };
+    std::vector<std::string_view> dev_keys, base_names;
+    for (const auto& d : devs_) dev_keys.push_back(sv(d.key));
+    for (const auto& b : bases_) base_names.push_back(sv(b.name));
+    utils::PerfectHash dev_hash, base_hash;
+    std::vector<uint32_t> dev_slots, base_slots;
+    hash_table(dev_keys, dev_hash, dev_slots);
+    hash_table(base_names, base_hash, base_slots);
+    const auto& dev_disp = dev_hash.displacements();
+    const auto& base_disp = base_hash.displacements();
+
+    L1ImageHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, L1_IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.version = L1_IMAGE_VERSION;
+    hdr.src_dev = (uint64_t)src_st.st_dev;
+    hdr.src_ino = (uint64_t)src_st.st_ino;
+    hdr.src_size = (uint64_t)src_st.st_size;
+    hdr.src_mtime_sec = (int64_t)src_st.st_mtim.tv_sec;
+    hdr.src_mtime_nsec = (int64_t)src_st.st_mtim.tv_nsec;
+    hdr.src_path = intern(src_path);
+
+    hdr.dev_hash_seed = dev_hash.seed();
+    hdr.base_hash_seed = base_hash.seed();
+
+    // Layout: header | blocks | devs | bases | rules | digits | props | seq | dev hash | base hash | strings
+    // (the 64-bit block table right after the header stays aligned)
+    uint32_t off = sizeof(L1ImageHeader);
+    hdr.n_blocks = (uint32_t)blocks_.size(); hdr.blocks_off = off; off += hdr.n_blocks * sizeof(L1ImageBlock);
+    hdr.n_devs = (uint32_t)devs_.size();   hdr.devs_off = off;  off += hdr.n_devs * sizeof(L1ImageDev);
+    hdr.n_bases = (uint32_t)bases_.size(); hdr.bases_off = off; off += hdr.n_bases * sizeof(L1ImageBase);
+    hdr.n_rules = (uint32_t)rules_.size(); hdr.rules_off = off; off += hdr.n_rules * sizeof(L1IfRule);
+    hdr.digits_off = off;                  off += hdr.n_rules * sizeof(L1ImageStr);
+    hdr.n_props = (uint32_t)props_.size(); hdr.props_off = off; off += hdr.n_props * sizeof(L1ImageProp);
+    hdr.n_seq = (uint32_t)seq_.size();     hdr.seq_off = off;   off += hdr.n_seq * sizeof(L1ImageStr);
+    hdr.n_dev_disp = (uint32_t)dev_disp.size(); hdr.dev_disp_off = off; off += hdr.n_dev_disp * sizeof(utils::PerfectHashDisp);
+    hdr.dev_slots_off = off;               off += (uint32_t)dev_slots.size() * sizeof(uint32_t);
+    hdr.n_base_disp = (uint32_t)base_disp.size(); hdr.base_disp_off = off; off += hdr.n_base_disp * sizeof(utils::PerfectHashDisp);
+    hdr.base_slots_off = off;              off += (uint32_t)base_slots.size() * sizeof(uint32_t);
+    hdr.strings_off = off;
+    hdr.strings_size = (uint32_t)strings_.size();
+    hdr.file_size = off + hdr.strings_size;
+
+    std::string buf;
+    buf.reserve(hdr.file_size);
+    buf.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    buf.append(reinterpret_cast<const char*>(blocks_.data()), hdr.n_blocks * sizeof(L1ImageBlock));
+    buf.append(reinterpret_cast<const char*>(devs_.data()), hdr.n_devs * sizeof(L1ImageDev));
+    buf.append(reinterpret_cast<const char*>(bases_.data()), hdr.n_bases * sizeof(L1ImageBase));
+    buf.append(reinterpret_cast<const char*>(rules_.data()), hdr.n_rules * sizeof(L1IfRule));
+    buf.append(reinterpret_cast<const char*>(digits_.data()), hdr.n_rules * sizeof(L1ImageStr));
+    buf.append(reinterpret_cast<const char*>(props_.data()), hdr.n_props * sizeof(L1ImageProp));
+    buf.append(reinterpret_cast<const char*>(seq_.data()), hdr.n_seq * sizeof(L1ImageStr));
+    buf.append(reinterpret_cast<const char*>(dev_disp.data()), dev_disp.size() * sizeof(utils::PerfectHashDisp));
+    buf.append(reinterpret_cast<const char*>(dev_slots.data()), dev_slots.size() * sizeof(uint32_t));
+    buf.append(reinterpret_cast<const char*>(base_disp.data()), base_disp.size() * sizeof(utils::PerfectHashDisp));
+    buf.append(reinterpret_cast<const char*>(base_slots.data()), base_slots.size() * sizeof(uint32_t));
+    buf.append(strings_);
+    return buf;
+}
+
+bool L1ImageWriter::write(const std::string& out_path, const std::string& src_path, const struct stat& src_st) {
+    return write_file(out_path, build(src_path, src_st));
+}
+
+bool L1ImageWriter::write_file(const std::string& out_path, std::string_view image) {
+    std::string tmp_path = out_path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    const char* p = image.data();
+    size_t left = image.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+
+    // The data has to be on disk before the rename makes it the image, or a
+    // crash can leave a valid-looking header over missing tables
+    bool ok = left == 0 && fsync(fd) == 0;
+    if (::close(fd) != 0) ok = false;
+    if (!ok || ::rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* --- Reader --- */
+
+L1Image::~L1Image() {
+    if (map_) munmap(map_, map_size_);
+}
+
+std::unique_ptr<L1Image> L1Image::open(const std::string& img_path, const std::string& src_path) {
+    struct stat src_st;
+    if (stat(src_path.c_str(), &src_st) != 0) return nullptr;
+
+    int fd = ::open(img_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat img_st;
+    if (fstat(fd, &img_st) != 0 || (size_t)img_st.st_size < sizeof(L1ImageHeader)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    void* map = mmap(nullptr, (size_t)img_st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return nullptr;
+
+    std::unique_ptr<L1Image> img(new L1Image());
+    if (!img->attach(map, (size_t)img_st.st_size)) return nullptr;
+
+    const L1ImageHeader& h = *img->hdr_;
+    // Automatic invalidation: the image must describe exactly this source file
+    if (img->str(h.src_path) != src_path ||
+        h.src_dev != (uint64_t)src_st.st_dev ||
+        h.src_ino != (uint64_t)src_st.st_ino ||
+        h.src_size != (uint64_t)src_st.st_size ||
+        h.src_mtime_sec != (int64_t)src_st.st_mtim.tv_sec ||
+        h.src_mtime_nsec != (int64_t)src_st.st_mtim.tv_nsec) {
+        return nullptr;
+    }
+    return img;
+}
+
+std::unique_ptr<L1Image> L1Image::from_bytes(std::string_view image) {
+    if (image.size() < sizeof(L1ImageHeader)) return nullptr;
+
+    // Pages of its own rather than heap memory, so the region can be write
+    // protected like a mapped image file
+    void* map = mmap(nullptr, image.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) return nullptr;
+    memcpy(map, image.data(), image.size());
+    if (mprotect(map, image.size(), PROT_READ) != 0) {
+        munmap(map, image.size());
+        return nullptr;
+    }
+
+    std::unique_ptr<L1Image> img(new L1Image());
+    if (!img->attach(map, image.size())) return nullptr;
+    return img;
+}
+
+bool L1Image::attach(void* map, size_t size) {
+    map_ = map;
+    map_size_ = size;
+
+    const char* base = static_cast<const char*>(map);
+    hdr_ = reinterpret_cast<const L1ImageHeader*>(base);
+    if (!validate()) return false;
+
+    const L1ImageHeader& h = *hdr_;
+    devs_ = reinterpret_cast<const L1ImageDev*>(base + h.devs_off);
+    bases_ = reinterpret_cast<const L1ImageBase*>(base + h.bases_off);
+    rules_ = reinterpret_cast<const L1IfRule*>(base + h.rules_off);
+    digits_ = reinterpret_cast<const L1ImageStr*>(base + h.digits_off);
+    props_ = reinterpret_cast<const L1ImageProp*>(base + h.props_off);
+    seq_ = reinterpret_cast<const L1ImageStr*>(base + h.seq_off);
+    blocks_ = reinterpret_cast<const L1ImageBlock*>(base + h.blocks_off);
+    strings_ = base + h.strings_off;
+    dev_disp_ = reinterpret_cast<const utils::PerfectHashDisp*>(base + h.dev_disp_off);
+    dev_slots_ = reinterpret_cast<const uint32_t*>(base + h.dev_slots_off);
+    base_disp_ = reinterpret_cast<const utils::PerfectHashDisp*>(base + h.base_disp_off);
+    base_slots_ = reinterpret_cast<const uint32_t*>(base + h.base_slots_off);
+    return true;
+}
+
+bool L1Image::validate() const {
+    const L1ImageHeader& h = *hdr_;
+    if (memcmp(h.magic, L1_IMAGE_MAGIC, sizeof(h.magic)) != 0) return false;
+    if (h.version != L1_IMAGE_VERSION || h.file_size != map_size_) return false;
+
+    auto table_ok = [&](uint32_t off, uint32_t n, size_t elem) {
+        return off >= sizeof(L1ImageHeader) && off <= map_size_ && (uint64_t)n * elem <= map_size_ - off;
+    };
+    if (!table_ok(h.devs_off, h.n_devs, sizeof(L1ImageDev)) ||
+        !table_ok(h.bases_off, h.n_bases, sizeof(L1ImageBase)) ||
+        !table_ok(h.rules_off, h.n_rules, sizeof(L1IfRule)) ||
+        !table_ok(h.digits_off, h.n_rules, sizeof(L1ImageStr)) ||
+        !table_ok(h.props_off, h.n_props, sizeof(L1ImageProp)) ||
+        !table_ok(h.seq_off, h.n_seq, sizeof(L1ImageStr)) ||
+        !table_ok(h.blocks_off, h.n_blocks, sizeof(L1ImageBlock)) || h.blocks_off % alignof(L1ImageBlock) ||
+        !table_ok(h.strings_off, h.strings_size, 1)) {
+        return false;
+    }
+
+    // A hash is either absent or covers the whole table; displacements must
+    // keep every slot in range
+    auto hash_ok = [&](uint32_t n_disp, uint32_t disp_off, uint32_t slots_off, uint32_t n) {
+        if (n_disp == 0) return true;
+        if (n == 0 || !table_ok(disp_off, n_disp, sizeof(utils::PerfectHashDisp)) ||
+            !table_ok(slots_off, n, sizeof(uint32_t))) {
+            return false;
+        }
+        const char* base = static_cast<const char*>(map_);
+        auto disp = reinterpret_cast<const utils::PerfectHashDisp*>(base + disp_off);
+        auto slots = reinterpret_cast<const uint32_t*>(base + slots_off);
+        for (uint32_t i = 0; i < n_disp; ++i) {
+            if (disp[i].d1 >= n) return false;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            if (slots[i] >= n) return false;
+        }
+        return true;
+    };
+    if (!hash_ok(h.n_dev_disp, h.dev_disp_off, h.dev_slots_off, h.n_devs) ||
+        !hash_ok(h.n_base_disp, h.base_disp_off, h.base_slots_off, h.n_bases)) {
+        return false;
+    }
+
+    // Check every string reference once here so lookups never need to
+    const char* base = static_cast<const char*>(map_);
+    const char* strings = base + h.strings_off;
+    auto str_ok = [&](const L1ImageStr& s) {
+        return (uint64_t)s.off + s.len < h.strings_size && strings[s.off + s.len] == '\0';
+    };
+    if (!str_ok(h.src_path)) return false;
+
+    auto devs = reinterpret_cast<const L1ImageDev*>(base + h.devs_off);
+    for (uint32_t i = 0; i < h.n_devs; ++i) {
+        if (!str_ok(devs[i].key)) return false;
+        if (devs[i].known_mask >> L1_KEY_COUNT) return false;
+        for (size_t k = 0; k < L1_KEY_COUNT; ++k) {
+            if ((devs[i].known_mask & (1u << k)) && !str_ok(devs[i].known[k])) return false;
+        }
+        if ((uint64_t)devs[i].props_begin + devs[i].props_count > h.n_props) return false;
+    }
+    auto bases = reinterpret_cast<const L1ImageBase*>(base + h.bases_off);
+    for (uint32_t i = 0; i < h.n_bases; ++i) {
+        if (!str_ok(bases[i].name) || (uint64_t)bases[i].rules_begin + bases[i].rules_count > h.n_rules) return false;
+    }
+    auto rules = reinterpret_cast<const L1IfRule*>(base + h.rules_off);
+    auto digits = reinterpret_cast<const L1ImageStr*>(base + h.digits_off);
+    for (uint32_t i = 0; i < h.n_rules; ++i) {
+        if (rules[i].dev >= h.n_devs || !str_ok(digits[i])) return false;
+        if (std::find(std::begin(L1_IF_KEYS), std::end(L1_IF_KEYS), (L1Key)rules[i].key) == std::end(L1_IF_KEYS)) return false;
+    }
+    auto props = reinterpret_cast<const L1ImageProp*>(base + h.props_off);
+    for (uint32_t i = 0; i < h.n_props; ++i) {
+        if (!str_ok(props[i].key) || !str_ok(props[i].val)) return false;
+    }
+    auto seq = reinterpret_cast<const L1ImageStr*>(base + h.seq_off);
+    for (uint32_t i = 0; i < h.n_seq; ++i) {
+        if (!str_ok(seq[i])) return false;
+    }
+    return true;
+}
+
+uint32_t L1Image::find_dev(std::string_view key) const {
+    if (hdr_->n_dev_disp) {
+        uint32_t slot = utils::PerfectHash::slot_of(key, hdr_->dev_hash_seed, dev_disp_, hdr_->n_dev_disp, hdr_->n_devs);
+        uint32_t dev = dev_slots_[slot];
+        return str(devs_[dev].key) == key ? dev : npos;
+    }
+
+    auto end = devs_ + hdr_->n_devs;
+    auto it = std::lower_bound(devs_, end, key,
+                               [&](const L1ImageDev& d, std::string_view k) { return str(d.key) < k; });
+    if (it != end && str(it->key) == key) return (uint32_t)(it - devs_);
+    return npos;
+}
+
+uint32_t L1Image::find_base(std::string_view base) const {
+    if (hdr_->n_base_disp) {
+        uint32_t slot = utils::PerfectHash::slot_of(base, hdr_->base_hash_seed, base_disp_, hdr_->n_base_disp, hdr_->n_bases);
+        uint32_t i = base_slots_[slot];
+        return str(bases_[i].name) == base ? i : npos;
+    }
+
+    auto end = bases_ + hdr_->n_bases;
+    auto it = std::lower_bound(bases_, end, base,
+                               [&](const L1ImageBase& b, std::string_view n) { return str(b.name) < n; });
+    if (it != end && str(it->name) == base) return (uint32_t)(it - bases_);
+    return npos;
+}
+
+uint32_t L1Image::find_if(std::string_view name, const L1IfLimits& limits) const {
+    return l1_resolve_if(name, limits, [this](std::string_view base, auto f) {
+        uint32_t i = find_base(base);
+        if (i != npos) for_each_rule(i, f);
+    });
+}
+
+std::optional<std::string_view> L1Image::prop(uint32_t dev, L1Key key) const {
+    if (dev >= hdr_->n_devs) return std::nullopt;
+    const L1ImageDev& d = devs_[dev];
+    if (d.known_mask & (1u << (unsigned)key)) return str(d.known[(size_t)key]);
+    return std::nullopt;
+}
+
+std::optional<std::string_view> L1Image::prop(uint32_t dev, std::string_view key) const {
+    if (auto k = l1_key(key)) return prop(dev, *k);
+    if (dev >= hdr_->n_devs) return std::nullopt;
+    auto first = props_ + devs_[dev].props_begin;
+    auto end = first + devs_[dev].props_count;
+    auto it = std::lower_bound(first, end, key,
+                               [&](const L1ImageProp& p, std::string_view k) { return str(p.key) < k; });
+    if (it != end && str(it->key) == key) return str(it->val);
+    return std::nullopt;
+}
+
+void L1Image::fill_block(uint32_t dev, L1Block& block) const {
+    const L1ImageDev& d = devs_[dev];
+    block.main_idx = d.main_idx;
+    block.bands = 1;
+    block.cells.clear();
+    block.cells.reserve(L1_KEY_COUNT + d.props_count);
+    block.known_mask = 0;
+    block.extra.clear();
+    // Views point straight into the mapping, which outlives the block
+    for (size_t k = 0; k < L1_KEY_COUNT; ++k) {
+        if (!(d.known_mask & (1u << k))) continue;
+        block.set((L1Key)k, (uint32_t)block.cells.size(), true);
+        block.cells.push_back(str(d.known[k]));
+    }
+    for (uint32_t i = 0; i < d.props_count; ++i) {
+        const L1ImageProp& p = props_[d.props_begin + i];
+        block.extra.emplace(str(p.key), L1Block::Column{ (uint32_t)block.cells.size(), true });
+        block.cells.push_back(str(p.val));
+    }
+    block.index_name = block.get(L1Key::INDEX, 0).value_or(std::string_view());
+}
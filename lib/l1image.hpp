@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include "l1schema.hpp"
+#include "l1ifrules.hpp"
+#include "../utils/perfecthash.hpp"
+
+/*
+ * Compiled l1profile image.
+ *
+ * The image is a flat, versioned, little-endian file holding the fully resolved
+ * profile: device records sorted by key (with the well-known properties in
+ * fixed L1Key slots), interface bases sorted by name with their naming rules
+ * (see l1ifrules.hpp), the per-device tables of remaining properties (sorted
+ * by key), the sequential main interface table used by idx2if and the
+ * fingerprint of every INDEX block it was built from. All strings
+ * live in one NUL-terminated string table. Device keys and interface bases
+ * also get a minimal perfect hash (displacement table plus slot -> record map)
+ * so lookups skip the binary search.
+ *
+ * The header records the inode, device, size and mtime of the source profile so
+ * a stale image is rejected as soon as the source file changes.
+ */
+
+static const uint32_t L1_IMAGE_VERSION = 5;
+
+struct L1ImageStr {
+    uint32_t off;
+    uint32_t len;
+};
+
+struct L1ImageHeader {
+    char magic[8];              // "L1PIMG\0\0"
+    uint32_t version;
+    uint32_t file_size;
+    uint64_t src_dev;
+    uint64_t src_ino;
+    uint64_t src_size;
+    int64_t src_mtime_sec;
+    int64_t src_mtime_nsec;
+    L1ImageStr src_path;
+    uint32_t n_devs, devs_off;  // L1ImageDev[n_devs], sorted by key
+    uint32_t n_bases, bases_off;// L1ImageBase[n_bases], sorted by name
+    uint32_t n_rules, rules_off;// L1IfRule[n_rules], grouped per base
+    uint32_t digits_off;        // L1ImageStr[n_rules], trailing digits of each rule's stem
+    uint32_t n_props, props_off;// L1ImageProp[n_props], grouped per device
+    uint32_t n_seq, seq_off;    // L1ImageStr[n_seq], main ifnames in sequential order
+    uint32_t strings_off, strings_size;
+    uint64_t dev_hash_seed;
+    uint64_t base_hash_seed;
+    uint32_t n_dev_disp, dev_disp_off; // PerfectHashDisp[n_dev_disp], 0: binary search only
+    uint32_t dev_slots_off;     // uint32_t[n_devs], hash slot -> device index
+    uint32_t n_base_disp, base_disp_off;
+    uint32_t base_slots_off;    // uint32_t[n_bases], hash slot -> base index
+    uint32_t n_blocks, blocks_off; // L1ImageBlock[n_blocks], by raw index
+};
+
+struct L1ImageDev {
+    L1ImageStr key;             // e.g. "MT7981_1_1"
+    uint32_t main_idx;
+    uint32_t sub_idx;
+    uint32_t props_begin;       // properties without an L1Key slot
+    uint32_t props_count;
+    uint32_t known_mask;        // bit per L1Key present in known[]
+    L1ImageStr known[L1_KEY_COUNT];
+};
+
+struct L1ImageBase {
+    L1ImageStr name;            // interface stem without its trailing digits
+    uint32_t rules_begin;       // by descending creation order
+    uint32_t rules_count;
+};
+
+struct L1ImageProp {
+    L1ImageStr key;
+    L1ImageStr val;
+};
+
+// Source INDEX block, see L1Parser::reload()
+struct L1ImageBlock {
+    uint64_t raw_idx;
+    uint64_t fp;
+};
+
+struct L1Block;
+
+/*
+ * Builds an image from an already resolved profile. Devices must be added in
+ * sorted key order; properties attach to the most recently added device.
+ */
+class L1ImageWriter {
+public:
+    uint32_t add_dev(std::string_view key, size_t main_idx, size_t sub_idx);
+    void add_prop(std::string_view key, std::string_view val);
+    // Rules of one base and their stem digits, in descending creation order
+    void add_if_base(std::string_view name, const L1IfRule* rules, const std::string_view* digits, size_t n);
+    void add_seq(std::string_view name);
+    void add_block(size_t raw_idx, uint64_t fp);
+
+    // The finished image, recording src_path and src_st as its source
+    std::string build(const std::string& src_path, const struct stat& src_st);
+    // The file is written to a temporary name and renamed into place so
+    // concurrent readers never observe a partial image.
+    bool write(const std::string& out_path, const std::string& src_path, const struct stat& src_st);
+    static bool write_file(const std::string& out_path, std::string_view image);
+
+private:
+    L1ImageStr intern(std::string_view s);
+
+    std::string strings_;
+    std::unordered_map<std::string, uint32_t> str_index_;
+    std::vector<L1ImageDev> devs_;
+    std::vector<L1ImageBase> bases_;
+    std::vector<L1IfRule> rules_;
+    std::vector<L1ImageStr> digits_;
+    std::vector<L1ImageProp> props_;
+    std::vector<L1ImageStr> seq_;
+    std::vector<L1ImageBlock> blocks_;
+};
+
+class L1Image {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    ~L1Image();
+
+    // Map an image and validate it against the current state of src_path.
+    // Returns nullptr if the image is missing, corrupt or stale.
+    static std::unique_ptr<L1Image> open(const std::string& img_path, const std::string& src_path);
+    // Copy a built image into a private read-only mapping (compact mode).
+    // Never stale: it describes whatever it was built from.
+    static std::unique_ptr<L1Image> from_bytes(std::string_view image);
+
+    // The whole image as mapped
+    std::string_view bytes() const { return std::string_view(static_cast<const char*>(map_), map_size_); }
+
+    uint32_t dev_count() const { return hdr_->n_devs; }
+    uint32_t seq_count() const { return hdr_->n_seq; }
+
+    uint32_t find_dev(std::string_view key) const;
+    // Device owning an interface name under the given limits, or npos
+    uint32_t find_if(std::string_view name, const L1IfLimits& limits) const;
+
+    std::string_view dev_key(uint32_t dev) const { return str(devs_[dev].key); }
+    size_t main_idx(uint32_t dev) const { return devs_[dev].main_idx; }
+    size_t sub_idx(uint32_t dev) const { return devs_[dev].sub_idx; }
+    std::optional<std::string_view> prop(uint32_t dev, std::string_view key) const;
+    std::optional<std::string_view> prop(uint32_t dev, L1Key key) const;
+    std::string_view seq_if(uint32_t i) const { return str(seq_[i]); }
+    uint32_t block_count() const { return hdr_->n_blocks; }
+    const L1ImageBlock& block(uint32_t i) const { return blocks_[i]; }
+
+    // Rebuild a device record as a single-band L1Block (used only by
+    // callers that need the legacy map views).
+    void fill_block(uint32_t dev, L1Block& block) const;
+    // f(key, value) for every property of dev, known slots first
+    template <typename Func>
+    void for_each_prop(uint32_t dev, Func f) const {
+        const L1ImageDev& d = devs_[dev];
+        for (size_t k = 0; k < L1_KEY_COUNT; ++k) {
+            if (d.known_mask & (1u << k)) f(std::string_view(L1_KEY_NAMES[k]), str(d.known[k]));
+        }
+        for (uint32_t i = 0; i < d.props_count; ++i) {
+            const L1ImageProp& p = props_[d.props_begin + i];
+            f(str(p.key), str(p.val));
+        }
+    }
+
+    uint32_t base_count() const { return hdr_->n_bases; }
+    std::string_view base_name(uint32_t i) const { return str(bases_[i].name); }
+    // Position of a base (see base_name()), or npos
+    uint32_t find_base(std::string_view base) const;
+    // f(rule, stem digits) in descending creation order until f returns true
+    template <typename Func>
+    void for_each_rule(uint32_t base, Func f) const {
+        const L1ImageBase& b = bases_[base];
+        for (uint32_t i = b.rules_begin; i < b.rules_begin + b.rules_count; ++i) {
+            if (f(rules_[i], str(digits_[i]))) return;
+        }
+    }
+
+private:
+    L1Image() = default;
+
+    std::string_view str(const L1ImageStr& s) const { return std::string_view(strings_ + s.off, s.len); }
+    bool validate() const;
+    // Validate the mapping and point the tables into it
+    bool attach(void* map, size_t size);
+
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    const L1ImageHeader* hdr_ = nullptr;
+    const L1ImageDev* devs_ = nullptr;
+    const L1ImageBase* bases_ = nullptr;
+    const L1IfRule* rules_ = nullptr;
+    const L1ImageStr* digits_ = nullptr;
+    const L1ImageProp* props_ = nullptr;
+    const L1ImageStr* seq_ = nullptr;
+    const L1ImageBlock* blocks_ = nullptr;
+    const char* strings_ = nullptr;
+    const utils::PerfectHashDisp* dev_disp_ = nullptr;
+    const uint32_t* dev_slots_ = nullptr;
+    const utils::PerfectHashDisp* base_disp_ = nullptr;
+    const uint32_t* base_slots_ = nullptr;
+};
@@ -1,59 +1,196 @@
 #include "l1parser.hpp"
+#include "l1image.hpp"
+#include "l1dat.hpp"
 #include "../utils/stringutils.hpp"
-#include <fstream>
+#include "../utils/fileview.hpp"
+#include "../utils/scan.hpp"
 #include <algorithm>
-#include <set>
-
-// Constants for logic replication (max number of virtual interfaces)
-static const size_t MAX_NUM_EXTIF = 16;
-static const size_t MAX_NUM_APCLI = 1;
-static const size_t MAX_NUM_WDS = 4;
-static const size_t MAX_NUM_MESH = 1;
-
-L1Parser::L1Parser() {}
-
-bool L1Parser::load(const std::string path) {
-    // Parse file into intermediate structure (sorted map ensures order)
-    RawDataMap raw_data = parse_raw_config(path);
-    if (raw_data.empty()) {
-        // If file is empty or cannot be opened, check existence to decide return value.
-        // Assuming false if file is bad.
-        std::ifstream f(path);
-        if (!f.good()) return false;
+#include <cstdint>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+
+L1Snapshot::L1Snapshot() {}
+L1Snapshot::~L1Snapshot() {}
+
+bool L1Snapshot::load(const std::string& path, bool use_cache) {
+    // A valid image answers every lookup directly, nothing to parse
+    if (use_cache) {
+        {
+            L1_STAT_PHASE(load_stats_, L1LoadPhase::read);
+            image_ = L1Image::open(L1_CACHE_PATH, path);
+        }
+        if (image_) {
+            src_path_ = path;
+            block_fps_.reserve(image_->block_count());
+            for (uint32_t i = 0; i < image_->block_count(); ++i) {
+                block_fps_.emplace_back((size_t)image_->block(i).raw_idx, image_->block(i).fp);
+            }
+            unchanged_ = same_blocks_as_base();
+            L1_STAT(load_stats_.from_image = true,
+                    load_stats_.entries = image_->dev_count(),
+                    load_stats_.main_ifs = image_->seq_count());
+            return true;
+        }
+    }
+
+    int fd;
+    {
+        L1_STAT_PHASE(load_stats_, L1LoadPhase::read);
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) return false;
+    bool ok = load_from_fd(fd);
+    close(fd);
+
+    // Remember which file revision we parsed so compile() can stamp the image
+    if (ok) src_path_ = path;
+    return ok;
+}
+
+bool L1Snapshot::load_from_fd(int fd) {
+    // Tokens are views into the mapping, which only has to outlive the build
+    utils::FileView file;
+    bool mapped;
+    {
+        L1_STAT_PHASE(load_stats_, L1LoadPhase::read);
+        mapped = fstat(fd, &src_st_) == 0 && file.open(fd, src_st_);
+    }
+    if (!mapped) return false;
+    return load_from_buffer(file.data());
+}
+
+bool L1Snapshot::load_from_buffer(std::string_view buf) {
+    src_path_.clear();
+
+    // The built snapshot takes 4 to 5 times the text plus a few KB, the
+    // more bands and per-band properties the more (l1bench-mem). A first
+    // chunk too small is followed by one 1.5 times its size, so size for
+    // the worst case. What only lives for the build (tokenized blocks, dedup
+    // index, sort and hash inputs) takes less and goes to a scratch arena
+    // freed on return.
+    arena_.reserve(buf.size() * 6 + 8192);
+    std::pmr::monotonic_buffer_resource scratch(buf.size() * 4 + 4096);
+
+    // Parse buffer into intermediate structure (sorted map ensures order)
+    RawDataMap raw_data(&scratch);
+    {
+        L1_STAT_PHASE(load_stats_, L1LoadPhase::tokenize);
+        raw_data = parse_raw_config(buf, &scratch);
     }
 
+    // Block order and content decide everything below, so equal fingerprints
+    // mean the base snapshot already holds the result
+    block_fps_.reserve(raw_data.size());
+    for (const auto& [raw_idx, props] : raw_data) {
+        block_fps_.emplace_back(raw_idx, block_fingerprint(props));
+    }
+    if (same_blocks_as_base()) {
+        unchanged_ = true;
+        return true;
+    }
+
+    // The dedup index is dead weight once every string is interned; it is
+    // dropped before scratch, however the build ends
+    pool_.index_in(&scratch);
+    struct IndexRelease {
+        utils::StringPool& pool;
+        ~IndexRelease() { pool.release_index(); }
+    } index_release{ pool_ };
+
     // Counter to track index per chipset type (e.g., 2nd MT7981 found)
-    std::unordered_map<std::string, size_t> chipset_counter;
+    std::pmr::unordered_map<std::string_view, size_t> chipset_counter(&scratch);
+    // At most one block each, entries keep pointers into blocks_
+    blocks_.reserve(raw_data.size());
+
+    // Blocks a parsed base_ holds with the same fingerprint. An image base
+    // keeps no columns to copy, every block is split again.
+    ReusableBlocks reusable(&scratch);
+    if (base_ && !base_->image_) {
+        // Both fingerprint lists are sorted by raw index
+        auto a = base_->block_fps_.cbegin(), b = block_fps_.cbegin();
+        while (a != base_->block_fps_.end() && b != block_fps_.end()) {
+            if (a->first < b->first) {
+                ++a;
+            } else if (b->first < a->first) {
+                ++b;
+            } else {
+                if (a->second == b->second) reusable.emplace(a->first, nullptr);
+                ++a, ++b;
+            }
+        }
+        for (const L1Block& old : base_->blocks_) {
+            auto it = reusable.find(old.raw_idx);
+            if (it != reusable.end()) it->second = &old;
+        }
+    }
 
     // Iterate through Raw Data (map automatically sorts by raw_idx)
-    for (const auto& [raw_idx, props] : raw_data) {
-        process_block(raw_idx, props, chipset_counter);
+    {
+        L1_STAT_PHASE(load_stats_, L1LoadPhase::blocks);
+        for (const auto& [raw_idx, props] : raw_data) {
+            process_block(raw_idx, props, chipset_counter, reusable, &scratch);
+        }
+    }
+    // The entries were timed on their own
+    L1_STAT(load_stats_.phase_ns[(size_t)L1LoadPhase::blocks] -= load_stats_.phase_ns[(size_t)L1LoadPhase::entries]);
+
+    // Sort keys to ensure consistent output for list(); creation order
+    // still decides which block owns a contested interface name
+    std::pmr::vector<std::string_view> created(ordered_dev_keys_, &scratch);
+    {
+        L1_STAT_PHASE(load_stats_, L1LoadPhase::sort);
+        std::sort(ordered_dev_keys_.begin(), ordered_dev_keys_.end());
+    }
+
+    {
+        L1_STAT_PHASE(load_stats_, L1LoadPhase::index);
+        build_hashes(&scratch);
+        build_if_rules(created, &scratch);
     }
 
-    // Sort keys to ensure consistent output for list()
-    std::sort(ordered_dev_keys_.begin(), ordered_dev_keys_.end());
+    L1_STAT(load_stats_.bytes = buf.size(),
+            load_stats_.blocks = raw_data.size(),
+            load_stats_.entries = ordered_dev_keys_.size(),
+            load_stats_.main_ifs = seq_ifs_.size(),
+            load_stats_.if_rules = if_rules_.size());
     return true;
 }
 
+// Independent of property order: one mixed hash per key/value pair, summed
+uint64_t L1Snapshot::block_fingerprint(const RawProps& props) {
+    uint64_t fp = props.size();
+    for (const auto& [k, v] : props) {
+        fp += utils::phash_mix(utils::phash(k, 0x6b6579) ^ (utils::phash(v, 0x76616c) * 0x9e3779b97f4a7c15ULL));
+    }
+    return fp;
+}
+
+bool L1Snapshot::same_blocks_as_base() const {
+    // The empty snapshot a parser starts with matches no file
+    return base_ && base_->if_limits_ == if_limits_ && !base_->block_fps_.empty() && base_->block_fps_ == block_fps_;
+}
+
 /**
  * Parses keys like "INDEX1", "INDEX1_main_ifname", "INDEX2".
  * Returns { 1, "INDEX" } or { 1, "main_ifname" }.
  */
-std::optional<std::pair<size_t, std::string>> L1Parser::parse_index_key(const std::string& key) {
+std::optional<std::pair<size_t, std::string_view>> L1Snapshot::parse_index_key(std::string_view key) {
     if (key.size() <= 5 || key.compare(0, 5, "INDEX") != 0) return std::nullopt;
 
     size_t num_start = 5;
     size_t num_end = num_start;
-    // Extract numbers after "INDEX"
-    while (num_end < key.size() && std::isdigit(key[num_end])) num_end++;
+    size_t idx = 0;
+    // Extract numbers after "INDEX", rejecting values that overflow size_t
+    while (num_end < key.size() && std::isdigit((unsigned char)key[num_end])) {
+        size_t digit = (size_t)(key[num_end] - '0');
+        if (idx > (SIZE_MAX - digit) / 10) return std::nullopt;
+        idx = idx * 10 + digit;
+        num_end++;
+    }
 
     if (num_end == num_start) return std::nullopt;
 
-    size_t idx = 0;
-    try {
-        idx = std::stoul(key.substr(num_start, num_end - num_start));
-    } catch (...) { return std::nullopt; }
-
     // Case "INDEX1" -> Value is Chip Name
     if (num_end == key.size()) return {{idx, "INDEX"}};
     // Case "INDEX1_prop" -> Property for that block
@@ -61,213 +198,608 @@ std::optional<std::pair<size_t, std::string>> L1Parser::parse_index_key(const st
     return std::nullopt;
 }
 
-L1Parser::RawDataMap L1Parser::parse_raw_config(const std::string& path) {
-    std::ifstream file(path);
-    RawDataMap raw_data;
-    if (!file.is_open()) return raw_data;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        // Handle comments: strip text after '#' and trim whitespace
-        std::string text = utils::trim(line.substr(0, line.find('#')));
-        if (text.empty()) continue;
-
-        size_t eq_pos = text.find('=');
-        if (eq_pos == std::string::npos) continue;
-
-        std::string key = utils::trim(text.substr(0, eq_pos));
-        std::string val = utils::trim(text.substr(eq_pos + 1));
+bool L1Snapshot::is_block_prop(std::string_view key) {
+    return key == "INDEX" || key.rfind("EEPROM", 0) == 0 || key == "mainidx";
+}
 
+/**
+ * Single pass over the buffer. Lines, keys and values are views into buf,
+ * nothing is copied until process_block() interns the results.
+ */
+L1Snapshot::RawDataMap L1Snapshot::parse_raw_config(std::string_view buf, std::pmr::memory_resource* tmp) {
+    RawDataMap raw_data(tmp);
+    utils::for_each_kv_line(buf, true, [&](std::string_view key, std::string_view val) {
         if (auto res = parse_index_key(key)) {
             raw_data[res->first][res->second] = val;
         }
-    }
+    });
     return raw_data;
 }
 
-void L1Parser::process_block(size_t raw_idx, 
-                              const std::unordered_map<std::string, std::string>& props,
-                              std::unordered_map<std::string, size_t>& chipset_counter) 
+void L1Snapshot::process_block(size_t raw_idx, 
+                              const RawProps& props,
+                              std::pmr::unordered_map<std::string_view, size_t>& chipset_counter,
+                              const ReusableBlocks& reusable,
+                              std::pmr::memory_resource* tmp) 
 {
     // Block must have an INDEX property (which contains the Chipset Name)
     if (props.find("INDEX") == props.end()) return;
-    std::string chip_name = props.at("INDEX");
+    std::string_view chip_name = pool_.intern(props.at("INDEX"));
 
     // Update global counter for this specific chipset
     size_t main_idx = ++chipset_counter[chip_name];
 
+    // Same text and the same place among its chipset: same columns
+    auto reuse = reusable.find(raw_idx);
+    if (reuse != reusable.end() && reuse->second && reuse->second->main_idx == main_idx) {
+        reuse_block(*reuse->second);
+        return;
+    }
+
     // Parse main_ifname (filter out empty entries)
     // Example: "ra0;rax0" -> ["ra0", "rax0"]
-    std::string main_if_str = (props.count("main_ifname")) ? props.at("main_ifname") : "";
-    std::vector<std::string> main_ifnames = utils::split(main_if_str, ';', false);
+    std::string_view main_if_str = (props.count("main_ifname")) ? props.at("main_ifname") : "";
+    std::pmr::vector<std::string_view> main_ifnames(tmp);
+    utils::for_each_split(main_if_str, ';', false, [&](std::string_view name) {
+        main_ifnames.push_back(pool_.intern(name));
+    });
 
     if (main_ifnames.empty()) return;
 
-    // Save RawBlock for idx2if (index to interface mapping) logic
-    raw_blocks_.push_back({raw_idx, main_ifnames});
+    // Number main interfaces sequentially for idx2if
+    seq_ifs_.insert(seq_ifs_.end(), main_ifnames.begin(), main_ifnames.end());
 
-    // Iterate through each Band/Radio (Sub Index) found in this block
-    for (size_t i = 0; i < main_ifnames.size(); ++i) {
-        create_and_map_entry(chip_name, main_idx, i + 1, raw_idx, i, main_ifnames[i], props);
-    }
-}
+    L1Block& block = blocks_.emplace_back(&arena_);
+    block.index_name = chip_name;
+    block.raw_idx = raw_idx;
+    block.main_idx = main_idx;
+    block.bands = main_ifnames.size();
+    size_t bands = block.bands;
 
-void L1Parser::create_and_map_entry(const std::string& chip_name,
-                                     size_t main_idx,
-                                     size_t sub_idx,
-                                     size_t raw_idx,
-                                     size_t band_index,
-                                     const std::string& current_main_if,
-                                     const std::unordered_map<std::string, std::string>& props)
-{
-    // Lambda: Get a property from props, split by ';', and return the part corresponding to the current band.
-    // Must keep empty tokens to maintain alignment.
-    auto get_split_prop = [&](const std::string& k) -> std::string {
-        if (props.find(k) != props.end()) {
-            auto parts = utils::split(props.at(k), ';', true);
-            if (band_index < parts.size()) return parts[band_index];
-        }
-        return "";
+    // Derived below, whatever the file says
+    auto derived = [](std::optional<L1Key> key) {
+        return key && (*key == L1Key::subidx || *key == L1Key::mainidx ||
+                       std::find(std::begin(L1_IF_KEYS), std::end(L1_IF_KEYS), *key) != std::end(L1_IF_KEYS));
     };
-
-    // Lambda: Logic to resolve default interface names if not specified in config
-    size_t default_id = raw_idx + 1;
-    auto resolve = [&](const std::string& k, const std::string& prefix, bool is_ext) -> std::string {
-        std::string val = get_split_prop(k);
-        if (!val.empty()) return val;
-        // Fallback logic
-        if (is_ext) return current_main_if + "_"; // e.g., ra0_1
-        return prefix + std::to_string(default_id) + "_"; // e.g., apcli1_0
+    // Exact size: the arena keeps whatever a growing vector leaves behind.
+    // The derived columns take main_ifname, four prefixes and subidx per
+    // band, plus mainidx.
+    size_t n_cells = 6 * bands + 1;
+    for (const auto& kv : props) {
+        if (!derived(l1_key(kv.first))) n_cells += is_block_prop(kv.first) ? 1 : bands;
+    }
+    block.cells.reserve(n_cells);
+
+    // Split each property once, one cell per band. Must keep empty tokens to
+    // maintain alignment; bands past the end of the list read "".
+    std::pmr::vector<std::string_view> parts(tmp);
+    auto split_column = [&](std::string_view val) -> const std::pmr::vector<std::string_view>& {
+        parts.clear();
+        utils::for_each_split(val, ';', true, [&](std::string_view part) { parts.push_back(part); });
+        parts.resize(bands);
+        return parts;
     };
+    for (const auto& [k, v] : props) {
+        auto key = l1_key(k);
+        if (derived(key)) continue;
+
+        uint32_t first = (uint32_t)block.cells.size();
+        bool shared = is_block_prop(k);
+        if (shared) {
+            block.cells.push_back(pool_.intern(v));
+        } else {
+            for (std::string_view part : split_column(v)) block.cells.push_back(pool_.intern(part));
+        }
+        // Known keys go to their slot and need no key string at all
+        if (key) block.set(*key, first, shared);
+        else block.set(pool_.intern(k), first, shared);
+    }
 
-    std::string ext_if = resolve("ext_ifname", "", true);
-    std::string apcli_if = resolve("apcli_ifname", "apcli", false);
-    std::string wds_if = resolve("wds_ifname", "wds", false);
-    std::string mesh_if = resolve("mesh_ifname", "mesh", false);
+    block.set(L1Key::main_ifname, (uint32_t)block.cells.size(), false);
+    block.cells.insert(block.cells.end(), main_ifnames.begin(), main_ifnames.end());
+
+    // Resolve default interface names if not specified in config
+    std::string default_id = std::to_string(raw_idx + 1);
+    for (L1Key k : { L1Key::ext_ifname, L1Key::apcli_ifname, L1Key::wds_ifname, L1Key::mesh_ifname }) {
+        auto it = props.find(l1_key_name(k));
+        split_column(it != props.end() ? it->second : std::string_view());
+        const char* prefix = k == L1Key::apcli_ifname ? "apcli" : k == L1Key::wds_ifname ? "wds" : "mesh";
+        block.set(k, (uint32_t)block.cells.size(), false);
+        for (size_t i = 0; i < bands; ++i) {
+            std::string_view val = parts[i];
+            if (!val.empty()) block.cells.push_back(pool_.intern(val));
+            else if (k == L1Key::ext_ifname) block.cells.push_back(pool_.intern(std::string(main_ifnames[i]) + "_")); // e.g., ra0_1
+            else block.cells.push_back(pool_.intern(prefix + default_id + "_")); // e.g., apcli1_0
+        }
+    }
 
-    // Build Entry object
-    L1Entry entry;
-    entry.index_name = chip_name;
-    entry.main_idx = main_idx;
-    entry.sub_idx = sub_idx;
+    block.set(L1Key::subidx, (uint32_t)block.cells.size(), false);
+    for (size_t i = 0; i < bands; ++i) block.cells.push_back(pool_.intern(std::to_string(i + 1)));
+    block.set(L1Key::mainidx, (uint32_t)block.cells.size(), true);
+    block.cells.push_back(pool_.intern(std::to_string(main_idx)));
 
-    // Fill properties
-    for (const auto& kv : props) {
-        const std::string& k = kv.first;
-        // Copy direct properties (global to the block)
-        if (k == "INDEX" || k.rfind("EEPROM", 0) == 0 || k == "mainidx") {
-            entry.props[k] = kv.second;
-        } else {
-            // Split properties that are specific to a band
-            entry.props[k] = get_split_prop(k);
-        }
+    // Iterate through each Band/Radio (Sub Index) found in this block
+    for (size_t i = 0; i < bands; ++i) {
+        create_and_map_entry(block, i);
     }
+}
 
-    // Override calculated/derived properties
-    entry.props["main_ifname"] = current_main_if;
-    entry.props["ext_ifname"] = ext_if;
-    entry.props["apcli_ifname"] = apcli_if;
-    entry.props["wds_ifname"] = wds_if;
-    entry.props["mesh_ifname"] = mesh_if;
-    entry.props["subidx"] = std::to_string(sub_idx);
-    entry.props["mainidx"] = std::to_string(main_idx);
+void L1Snapshot::reuse_block(const L1Block& old) {
+    L1Block& block = blocks_.emplace_back(&arena_);
+    block.index_name = pool_.intern(old.index_name);
+    block.raw_idx = old.raw_idx;
+    block.main_idx = old.main_idx;
+    block.bands = old.bands;
+    // The layout carries over as is, only the strings move to this pool
+    block.cells.reserve(old.cells.size());
+    for (std::string_view cell : old.cells) block.cells.push_back(pool_.intern(cell));
+    block.known = old.known;
+    block.known_mask = old.known_mask;
+    block.extra.reserve(old.extra.size());
+    for (const auto& [key, col] : old.extra) block.extra.emplace(pool_.intern(key), col);
+    L1_STAT(load_stats_.blocks_reused++);
+
+    const L1Block::Column& main = block.known[(size_t)L1Key::main_ifname];
+    seq_ifs_.insert(seq_ifs_.end(), block.cells.begin() + main.first, block.cells.begin() + main.first + block.bands);
+    for (size_t i = 0; i < block.bands; ++i) {
+        create_and_map_entry(block, i);
+    }
+}
+
+void L1Snapshot::create_and_map_entry(const L1Block& block, size_t band) {
+    L1_STAT_PHASE(load_stats_, L1LoadPhase::entries);
+
+    // An entry is only the coordinates of its band in the block's columns
+    size_t sub_idx = band + 1;
+    L1Entry entry{ block.index_name, block.main_idx, sub_idx, &block, band };
 
     // Store in Profile map
     // Key format: "ChipName_MainIndex_SubIndex" (e.g., MT7981_1_1)
-    std::string dev_key = chip_name + "_" + std::to_string(main_idx) + "_" + std::to_string(sub_idx);
+    std::string_view dev_key = pool_.intern(std::string(block.index_name) + "_" + std::to_string(block.main_idx) + "_" + std::to_string(sub_idx));
     dev_map_[dev_key] = entry;
+    // Interface names follow from the *_ifname slots, see build_if_rules()
     ordered_dev_keys_.push_back(dev_key);
+}
 
-    // Create Reverse Map (Interface Name -> Entry)
-    auto map_if = [&](const std::string& name) {
-        if (!name.empty()) if_map_[name] = entry;
+void L1Snapshot::build_hashes(std::pmr::memory_resource* tmp) {
+    // Falls back to the unordered maps if a hash cannot be built
+    auto build = [tmp](const auto& map, utils::PerfectHash& ph, std::pmr::vector<NameSlot>& slots, auto entry_of) {
+        std::pmr::vector<std::string_view> keys(tmp);
+        keys.reserve(map.size());
+        for (const auto& kv : map) keys.push_back(kv.first);
+        slots.clear();
+        if (keys.empty() || !ph.build(keys)) return;
+        slots.resize(keys.size());
+        for (const auto& kv : map) slots[ph.slot(kv.first)] = { kv.first, entry_of(kv.second) };
     };
+    build(dev_map_, dev_hash_, dev_slots_, [](const L1Entry& e) { return &e; });
+}
 
-    map_if(current_main_if);
-    // Map virtual interfaces based on max counts
-    for (size_t j = 1; j < MAX_NUM_EXTIF; ++j) map_if(ext_if + std::to_string(j));
-    for (size_t j = 0; j < MAX_NUM_APCLI; ++j) map_if(apcli_if + std::to_string(j));
-    for (size_t j = 0; j < MAX_NUM_WDS; ++j) map_if(wds_if + std::to_string(j));
-    for (size_t j = 0; j < MAX_NUM_MESH; ++j) map_if(mesh_if + std::to_string(j));
+/**
+ * One rule per (stem, band): the main interface name and each virtual
+ * prefix. Names are resolved against these on lookup, so neither the table
+ * size nor the load time depend on the interface limits.
+ */
+void L1Snapshot::build_if_rules(const std::pmr::vector<std::string_view>& created, std::pmr::memory_resource* tmp) {
+    // unordered_map never relocates its nodes, so entry addresses stay valid
+    std::pmr::unordered_map<std::string_view, uint32_t> dev_index(tmp);
+    dev_entries_.clear();
+    dev_entries_.reserve(ordered_dev_keys_.size());
+    for (const auto& key : ordered_dev_keys_) {
+        dev_index[key] = (uint32_t)dev_entries_.size();
+        dev_entries_.push_back(&dev_map_.at(key));
+    }
+
+    struct Pending {
+        std::string_view base, digits;
+        L1IfRule rule;
+    };
+    std::pmr::vector<Pending> rules(tmp);
+    rules.reserve(created.size() * std::size(L1_IF_KEYS));
+    for (uint32_t order = 0; order < created.size(); ++order) {
+        const L1Entry& e = dev_map_.at(created[order]);
+        uint32_t dev = dev_index.at(created[order]);
+        for (L1Key k : L1_IF_KEYS) {
+            auto stem = e.get(k);
+            if (!stem || stem->empty()) continue;
+            auto [base, digits] = l1_if_split(*stem);
+            rules.push_back({ base, digits, { dev, order, (uint32_t)k } });
+        }
+    }
+    std::sort(rules.begin(), rules.end(), [](const Pending& a, const Pending& b) {
+        if (a.base != b.base) return a.base < b.base;
+        return a.rule.order > b.rule.order;
+    });
+
+    if_bases_.clear();
+    if_rules_.clear();
+    if_digits_.clear();
+    if_rules_.reserve(rules.size());
+    if_digits_.reserve(rules.size());
+    for (const auto& r : rules) {
+        if (if_bases_.empty() || if_bases_.back().name != r.base) {
+            if_bases_.push_back({ r.base, (uint32_t)if_rules_.size(), 0 });
+        }
+        if_rules_.push_back(r.rule);
+        if_digits_.push_back(r.digits);
+        if_bases_.back().count++;
+    }
+
+    // Falls back to a binary search over the sorted bases
+    std::pmr::vector<std::string_view> names(tmp);
+    names.reserve(if_bases_.size());
+    for (const auto& b : if_bases_) names.push_back(b.name);
+    if (names.empty() || !if_hash_.build(names)) return;
+    // Reordered in place, the arena would keep a second copy
+    std::pmr::vector<IfBase> slots(if_bases_.size(), tmp);
+    for (const auto& b : if_bases_) slots[if_hash_.slot(b.name)] = b;
+    std::copy(slots.begin(), slots.end(), if_bases_.begin());
 }
 
-std::optional<std::string> L1Parser::get_prop(const std::string& dev, const std::string& key) const {
-    auto it = dev_map_.find(dev);
-    if (it != dev_map_.end()) {
-        auto pit = it->second.props.find(key);
-        if (pit != it->second.props.end()) return pit->second;
+const L1Entry* L1Snapshot::find_dev_entry(std::string_view key) const {
+    if (!dev_slots_.empty()) {
+        const NameSlot& s = dev_slots_[dev_hash_.slot(key)];
+        return s.first == key ? s.second : nullptr;
     }
-    return std::nullopt;
+    auto it = dev_map_.find(key);
+    return it != dev_map_.end() ? &it->second : nullptr;
 }
 
-std::vector<std::string> L1Parser::list_devs() const {
-    return ordered_dev_keys_;
+const L1Snapshot::IfBase* L1Snapshot::find_if_base(std::string_view base) const {
+    if (if_bases_.empty()) return nullptr;
+
+    if (if_hash_.size()) {
+        const IfBase& b = if_bases_[if_hash_.slot(base)];
+        return b.name == base ? &b : nullptr;
+    }
+    auto it = std::lower_bound(if_bases_.begin(), if_bases_.end(), base,
+                               [](const IfBase& a, std::string_view n) { return a.name < n; });
+    return (it != if_bases_.end() && it->name == base) ? &*it : nullptr;
+}
+
+uint32_t L1Snapshot::find_if_dev(std::string_view name) const {
+    if (image_) return image_->find_if(name, if_limits_);
+    return l1_resolve_if(name, if_limits_, [this](std::string_view base, auto f) {
+        const IfBase* b = find_if_base(base);
+        if (!b) return;
+        for (uint32_t i = b->first; i < b->first + b->count; ++i) {
+            if (f(if_rules_[i], if_digits_[i])) return;
+        }
+    });
 }
 
-std::optional<std::string> L1Parser::if2zone(const std::string& ifname) const {
-    auto it = if_map_.find(ifname);
-    if (it != if_map_.end()) {
-        auto pit = it->second.props.find("nvram_zone");
-        if (pit != it->second.props.end()) return pit->second;
+const L1Entry* L1Snapshot::find_if_entry(std::string_view name) const {
+    uint32_t dev = find_if_dev(name);
+    return dev != UINT32_MAX ? dev_entries_[dev] : nullptr;
+}
+
+// Visit every interface rule as (stem, rule), image or parsed
+template <typename Func>
+void L1Snapshot::for_each_if_rule(Func f) const {
+    std::string stem;
+    auto visit = [&](std::string_view base, std::string_view digits, const L1IfRule& r) {
+        stem.assign(base.data(), base.size());
+        stem.append(digits.data(), digits.size());
+        f(std::string_view(stem), r);
+    };
+    if (image_) {
+        for (uint32_t i = 0; i < image_->base_count(); ++i) {
+            image_->for_each_rule(i, [&](const L1IfRule& r, std::string_view digits) {
+                visit(image_->base_name(i), digits, r);
+                return false;
+            });
+        }
+        return;
+    }
+    for (const auto& b : if_bases_) {
+        for (uint32_t i = b.first; i < b.first + b.count; ++i) visit(b.name, if_digits_[i], if_rules_[i]);
     }
-    return std::nullopt;
 }
 
-std::optional<std::string> L1Parser::if2dat(const std::string& ifname) const {
-    auto it = if_map_.find(ifname);
-    if (it != if_map_.end()) {
-        auto pit = it->second.props.find("profile_path");
-        if (pit != it->second.props.end()) return pit->second;
+bool L1Snapshot::compile(const std::string& out_path) const {
+    if (src_path_.empty()) return false;
+    // A compact snapshot is an image already, a mapped one is not ours to copy
+    if (compact_) return L1ImageWriter::write_file(out_path, image_->bytes());
+    if (image_) return false;
+
+    L1ImageWriter w;
+    add_to_image(w);
+    return w.write(out_path, src_path_, src_st_);
+}
+
+void L1Snapshot::add_to_image(L1ImageWriter& w) const {
+    // Devices go in ordered_dev_keys_ order, so rule device indexes carry over
+    for (size_t i = 0; i < ordered_dev_keys_.size(); ++i) {
+        const L1Entry& entry = *dev_entries_[i];
+        w.add_dev(ordered_dev_keys_[i], entry.main_idx, entry.sub_idx);
+        entry.for_each([&](std::string_view k, std::string_view v) { w.add_prop(k, v); });
     }
+    for (const auto& b : if_bases_) w.add_if_base(b.name, if_rules_.data() + b.first, if_digits_.data() + b.first, b.count);
+    for (const auto& name : seq_ifs_) w.add_seq(name);
+    for (const auto& [raw_idx, fp] : block_fps_) w.add_block(raw_idx, fp);
+}
+
+void L1Snapshot::materialize_devs() const {
+    // Concurrent readers of one snapshot may race here, build the map once
+    std::call_once(devs_materialized_, [this]() {
+        if (!image_) return;
+        // Blocks, their cells and dev_map_ take about twice the image
+        arena_.reserve(image_->bytes().size() * 2 + image_->dev_count() * sizeof(L1Block));
+        blocks_.reserve(image_->dev_count());
+        for (uint32_t i = 0; i < image_->dev_count(); ++i) {
+            L1Block& b = blocks_.emplace_back(&arena_);
+            image_->fill_block(i, b);
+            dev_map_[image_->dev_key(i)] = { b.index_name, b.main_idx, image_->sub_idx(i), &b, 0 };
+        }
+    });
+}
+
+void L1Snapshot::materialize() const {
+    materialize_devs();
+    std::call_once(materialized_, [this]() {
+        std::vector<const L1Entry*> entries(dev_entries_.begin(), dev_entries_.end());
+        if (image_) {
+            for (uint32_t i = 0; i < image_->dev_count(); ++i) entries.push_back(&dev_map_.at(image_->dev_key(i)));
+        }
+
+        // Expand the rules in creation order: a later block takes over names,
+        // as when every name was registered at load
+        std::vector<std::pair<std::string, L1IfRule>> rules;
+        for_each_if_rule([&](std::string_view stem, const L1IfRule& r) { rules.push_back({ std::string(stem), r }); });
+        std::stable_sort(rules.begin(), rules.end(),
+                         [](const auto& a, const auto& b) { return a.second.order < b.second.order; });
+        for (const auto& [stem, r] : rules) {
+            l1_for_each_if_name(stem, (L1Key)r.key, if_limits_, [&](std::string_view name) {
+                if_map_[if_names_.intern(name)] = entries[r.dev];
+            });
+        }
+        materialized_done_.store(true, std::memory_order_release);
+    });
+}
+
+const std::pmr::unordered_map<std::string_view, L1Entry>& L1Snapshot::get_all() const {
+    materialize_devs();
+    return dev_map_;
+}
+
+const std::unordered_map<std::string_view, const L1Entry*>& L1Snapshot::get_if_map() const {
+    materialize();
+    return if_map_;
+}
+
+bool L1Snapshot::sorted_props(std::string_view dev, PropList& out) const {
+    out.clear();
+    auto add = [&](std::string_view k, std::string_view v) { out.emplace_back(k, v); };
+    if (image_) {
+        uint32_t i = image_->find_dev(dev);
+        if (i == L1Image::npos) return false;
+        image_->for_each_prop(i, add);
+    } else {
+        const L1Entry* e = find_dev_entry(dev);
+        if (!e) return false;
+        e->for_each(add);
+    }
+    std::sort(out.begin(), out.end());
+    return true;
+}
+
+std::optional<std::string_view> L1Snapshot::prop_view(std::string_view dev, std::string_view key) const {
+    if (image_) return image_->prop(image_->find_dev(dev), key);
+
+    if (const L1Entry* e = find_dev_entry(dev)) return e->get(key);
     return std::nullopt;
 }
 
-std::optional<std::string> L1Parser::if2dbdcidx(const std::string& ifname) const {
-    auto it = if_map_.find(ifname);
-    if (it != if_map_.end()) {
-        return std::to_string(it->second.sub_idx);
+std::optional<std::string_view> L1Snapshot::if_prop_view(std::string_view ifname, std::string_view key) const {
+    if (image_) return image_->prop(find_if_dev(ifname), key);
+
+    if (const L1Entry* e = find_if_entry(ifname)) return e->get(key);
+    return std::nullopt;
+}
+
+std::optional<std::string_view> L1Snapshot::prop_view(std::string_view dev, L1Key key) const {
+    if (image_) return image_->prop(image_->find_dev(dev), key);
+
+    if (const L1Entry* e = find_dev_entry(dev)) return e->get(key);
+    return std::nullopt;
+}
+
+std::optional<std::string_view> L1Snapshot::if_prop_view(std::string_view ifname, L1Key key) const {
+    if (image_) return image_->prop(find_if_dev(ifname), key);
+
+    if (const L1Entry* e = find_if_entry(ifname)) return e->get(key);
+    return std::nullopt;
+}
+
+std::optional<size_t> L1Snapshot::if_sub_idx(std::string_view ifname) const {
+    if (image_) {
+        uint32_t dev = find_if_dev(ifname);
+        if (dev != L1Image::npos) return image_->sub_idx(dev);
+        return std::nullopt;
     }
+
+    if (const L1Entry* e = find_if_entry(ifname)) return e->sub_idx;
     return std::nullopt;
 }
 
-std::vector<std::string> L1Parser::zone2if(const std::string& zone) const {
-    std::vector<std::string> ifaces;
-    for (const auto& pair : dev_map_) {
-        const auto& props = pair.second.props;
-        auto zit = props.find("nvram_zone");
-        if (zit != props.end() && zit->second == zone) {
-            auto add_if = [&](const char* k) {
-                auto it = props.find(k);
-                if (it != props.end() && !it->second.empty()) {
-                    ifaces.push_back(it->second);
-                }
-            };
-            add_if("main_ifname");
-            add_if("ext_ifname");
-            add_if("apcli_ifname");
-            add_if("wds_ifname");
-            add_if("mesh_ifname");
-
-            return ifaces;
+size_t L1Snapshot::dev_count() const {
+    return image_ ? image_->dev_count() : ordered_dev_keys_.size();
+}
+
+std::string_view L1Snapshot::dev_key(size_t i) const {
+    return image_ ? image_->dev_key((uint32_t)i) : ordered_dev_keys_[i];
+}
+
+size_t L1Snapshot::zone2if_views(std::string_view zone, std::string_view* out, size_t max) const {
+    // Prefixes of the zone's first device, as the original l1util reports them.
+    // The relation index leaves out devices with an empty nvram_zone, which
+    // the original still matched against "".
+    std::string_view dev;
+    if (zone.empty()) {
+        for (size_t i = 0; i < dev_count() && dev.empty(); ++i) {
+            auto z = prop_view(dev_key(i), L1Key::nvram_zone);
+            if (z && z->empty()) dev = dev_key(i);
         }
+    } else {
+        const auto& devs = zone2devs(zone);
+        if (!devs.empty()) dev = devs.front();
+    }
+    if (dev.empty()) return 0;
+
+    size_t n = 0;
+    for (L1Key k : L1_IF_KEYS) {
+        auto v = prop_view(dev, k);
+        if (!v || v->empty()) continue;
+        if (n < max) out[n] = *v;
+        n++;
     }
-    return ifaces;
+    return n;
 }
 
-std::optional<std::string> L1Parser::idx2if(size_t target) const {
-    if (target <= 0) return std::nullopt;
-    size_t cumulative = 0;
+/**
+ * Derive the relation indexes from the resolved profile. Each device's
+ * interface names are expanded from its rules (main, ext, apcli, wds, mesh)
+ * and kept only where the name still resolves to that device, since a later
+ * block may have claimed the same name.
+ */
+void L1Snapshot::build_relations() const {
+    // Stored name view if this device owns the interface
+    auto owned = [&](size_t dev, std::string_view name) -> std::optional<std::string_view> {
+        if (find_if_dev(name) != dev) return std::nullopt;
+        return rel_.names.intern(name);
+    };
 
-    // Find which block matches the sequential index
-    for (const auto& block : raw_blocks_) {
-        size_t count = block.main_ifnames.size();
-        if (target > cumulative && target <= cumulative + count) {
-            size_t offset = target - cumulative - 1;
-            if (offset < block.main_ifnames.size()) {
-                return block.main_ifnames[offset];
-            }
+    // A name listed by several blocks keeps its first index
+    for (size_t i = seq_count(); i > 0; --i) rel_.if_seq[seq_if(i - 1)] = i;
+
+    for (size_t dev = 0; dev < dev_count(); ++dev) {
+        std::string_view key = dev_key(dev);
+        auto prop = [&](L1Key k) { return prop_view(key, k).value_or(std::string_view()); };
+
+        std::vector<std::string_view>& ifs = rel_.dev_ifs[key];
+        auto add = [&](std::string_view name) {
+            if (name.empty()) return;
+            auto v = owned(dev, name);
+            if (v && std::find(ifs.begin(), ifs.end(), *v) == ifs.end()) ifs.push_back(*v);
+        };
+        for (L1Key k : L1_IF_KEYS) {
+            std::string_view stem = prop(k);
+            if (!stem.empty()) l1_for_each_if_name(stem, k, if_limits_, add);
+        }
+
+        std::string_view zone = prop(L1Key::nvram_zone);
+        if (!zone.empty()) {
+            rel_.zone_devs[zone].push_back(key);
+            auto& zifs = rel_.zone_ifs[zone];
+            zifs.insert(zifs.end(), ifs.begin(), ifs.end());
+        }
+        std::string_view dat = prop(L1Key::profile_path);
+        if (!dat.empty()) {
+            auto& difs = rel_.dat_ifs[dat];
+            difs.insert(difs.end(), ifs.begin(), ifs.end());
         }
-        cumulative += count;
     }
+    relations_done_.store(true, std::memory_order_release);
+}
+
+const std::vector<std::string_view>& L1Snapshot::relation(const RelationMap& map, std::string_view key) const {
+    static const std::vector<std::string_view> none;
+    std::call_once(relations_built_, [this]() { build_relations(); });
+    auto it = map.find(key);
+    return it != map.end() ? it->second : none;
+}
+
+const std::vector<std::string_view>& L1Snapshot::zone2devs(std::string_view zone) const {
+    return relation(rel_.zone_devs, zone);
+}
+
+const std::vector<std::string_view>& L1Snapshot::zone2ifs(std::string_view zone) const {
+    return relation(rel_.zone_ifs, zone);
+}
+
+const std::vector<std::string_view>& L1Snapshot::dat2ifs(std::string_view dat_path) const {
+    return relation(rel_.dat_ifs, dat_path);
+}
+
+const std::vector<std::string_view>& L1Snapshot::dev2ifs(std::string_view dev) const {
+    return relation(rel_.dev_ifs, dev);
+}
+
+size_t L1Snapshot::seq_count() const {
+    return image_ ? image_->seq_count() : seq_ifs_.size();
+}
+
+std::string_view L1Snapshot::seq_if(size_t i) const {
+    return image_ ? image_->seq_if((uint32_t)i) : seq_ifs_[i];
+}
+
+std::optional<std::string_view> L1Snapshot::idx2if_view(size_t target) const {
+    if (target == 0 || target > seq_count()) return std::nullopt;
+    return seq_if(target - 1);
+}
+
+std::optional<size_t> L1Snapshot::if2idx(std::string_view ifname) const {
+    std::call_once(relations_built_, [this]() { build_relations(); });
+    auto it = rel_.if_seq.find(ifname);
+    if (it != rel_.if_seq.end()) return it->second;
+    return std::nullopt;
+}
+
+static std::optional<std::string> to_string(std::optional<std::string_view> v) {
+    if (v) return std::string(*v);
     return std::nullopt;
-}
\ No newline at end of file
+}
+
+std::optional<std::string> L1Snapshot::get_prop(const std::string& dev, const std::string& key) const {
+    return to_string(prop_view(dev, key));
+}
+
+std::vector<std::string> L1Snapshot::list_devs() const {
+    std::vector<std::string> devs;
+    devs.reserve(dev_count());
+    for (size_t i = 0; i < dev_count(); ++i) devs.emplace_back(dev_key(i));
+    return devs;
+}
+
+std::optional<std::string> L1Snapshot::get_if_prop(const std::string& ifname, const std::string& key) const {
+    return to_string(if_prop_view(ifname, key));
+}
+
+std::optional<std::string> L1Snapshot::if2zone(const std::string& ifname) const {
+    return to_string(if_prop_view(ifname, L1Key::nvram_zone));
+}
+
+std::optional<std::string> L1Snapshot::if2dat(const std::string& ifname) const {
+    return to_string(if_prop_view(ifname, L1Key::profile_path));
+}
+
+std::optional<std::string> L1Snapshot::dat_get(const std::string& ifname, const std::string& key) const {
+    auto path = if_prop_view(ifname, L1Key::profile_path);
+    if (!path || path->empty()) return std::nullopt;
+    auto dat = L1DatCache::instance().get(*path);
+    if (!dat) return std::nullopt;
+    return to_string(dat->get(key));
+}
+
+std::optional<std::string> L1Snapshot::if2dbdcidx(const std::string& ifname) const {
+    auto idx = if_sub_idx(ifname);
+    if (idx) return std::to_string(*idx);
+    return std::nullopt;
+}
+
+std::vector<std::string> L1Snapshot::zone2if(const std::string& zone) const {
+    std::string_view views[std::size(L1_IF_KEYS)];
+    size_t n = zone2if_views(zone, views, std::size(views));
+    return std::vector<std::string>(views, views + n);
+}
+
+std::optional<std::string> L1Snapshot::idx2if(size_t target) const {
+    return to_string(idx2if_view(target));
+}
+
+std::vector<std::string> L1Snapshot::idx_table() const {
+    std::vector<std::string> table;
+    table.reserve(seq_count());
+    for (size_t i = 0; i < seq_count(); ++i) table.emplace_back(seq_if(i));
+    return table;
+}
@@ -0,0 +1,91 @@
+#include "l1watch.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Writers rarely finish a profile in one syscall, wait for this much silence
+static const int DEBOUNCE_MS = 50;
+
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+
+std::unique_ptr<L1Watcher> L1Watcher::start(const std::string& path, std::function<void()> on_change) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (name.empty()) return nullptr;
+
+    int ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ifd < 0) return nullptr;
+    if (inotify_add_watch(ifd, dir.c_str(), WATCH_MASK) < 0) {
+        close(ifd);
+        return nullptr;
+    }
+
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd < 0) {
+        close(ifd);
+        return nullptr;
+    }
+
+    std::unique_ptr<L1Watcher> w(new L1Watcher(ifd, efd, std::move(name), std::move(on_change)));
+    // Keep process signals (e.g. the daemon's SIGTERM) on the caller's threads
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    w->thread_ = std::thread(&L1Watcher::run, w.get());
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+    return w;
+}
+
+L1Watcher::L1Watcher(int inotify_fd, int stop_fd, std::string name, std::function<void()> on_change)
+    : inotify_fd_(inotify_fd), stop_fd_(stop_fd), name_(std::move(name)), on_change_(std::move(on_change)) {}
+
+L1Watcher::~L1Watcher() {
+    uint64_t one = 1;
+    if (write(stop_fd_, &one, sizeof(one)) < 0) {
+        // eventfd writes only fail on counter overflow, the thread wakes anyway
+    }
+    if (thread_.joinable()) thread_.join();
+    close(inotify_fd_);
+    close(stop_fd_);
+}
+
+void L1Watcher::run() {
+    alignas(struct inotify_event) char buf[4096];
+    bool pending = false;
+
+    for (;;) {
+        struct pollfd pfds[2] = {
+            { stop_fd_, POLLIN, 0 },
+            { inotify_fd_, POLLIN, 0 },
+        };
+        int n = poll(pfds, 2, pending ? DEBOUNCE_MS : -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (pfds[0].revents) return;
+
+        if (n == 0) {
+            // Quiet period elapsed after a change to our file
+            pending = false;
+            on_change_();
+            continue;
+        }
+
+        ssize_t len;
+        while ((len = read(inotify_fd_, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                auto* ev = reinterpret_cast<struct inotify_event*>(p);
+                if (ev->mask & IN_Q_OVERFLOW) pending = true;
+                else if (ev->len && name_ == ev->name) pending = true;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+    }
+}
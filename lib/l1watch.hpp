@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+/*
+ * Background inotify watch on one profile path.
+ *
+ * The parent directory is watched rather than the file itself, so both
+ * in-place edits and the usual "write temp file, rename over" pattern are
+ * seen, and the watch survives the file being replaced. Bursts of events are
+ * coalesced: on_change runs once the path has been quiet for a short while.
+ */
+class L1Watcher {
+public:
+    ~L1Watcher();
+
+    // nullptr when inotify is unavailable or the directory cannot be watched
+    static std::unique_ptr<L1Watcher> start(const std::string& path, std::function<void()> on_change);
+
+private:
+    L1Watcher(int inotify_fd, int stop_fd, std::string name, std::function<void()> on_change);
+
+    void run();
+
+    int inotify_fd_;
+    int stop_fd_;
+    std::string name_; // basename of the watched path
+    std::function<void()> on_change_;
+    std::thread thread_;
+};
@@ -0,0 +1,85 @@
+#include "l1parser.hpp"
+#include "l1image.hpp"
+
+/*
+ * Memory accounting and compact mode. Sizes are estimates from the
+ * containers' sizes and capacities: a hash map node is taken as its value
+ * plus a next pointer and a cached hash (libstdc++ and libc++ both cache the
+ * hash of string keys), allocator headers are not counted.
+ */
+
+namespace {
+
+template <typename T, typename A>
+uint64_t vec_bytes(const std::vector<T, A>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+template <typename Map>
+uint64_t map_bytes(const Map& m) {
+    return m.bucket_count() * sizeof(void*) + m.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+}
+
+uint64_t hash_bytes(const utils::PerfectHash& ph) {
+    return vec_bytes(ph.displacements());
+}
+
+} // namespace
+
+L1MemUsage L1Snapshot::memory_usage() const {
+    L1MemUsage m;
+    m.compact = compact_;
+    m.strings = pool_.capacity();
+
+    m.blocks = vec_bytes(blocks_);
+    for (const auto& b : blocks_) m.blocks += vec_bytes(b.cells) + map_bytes(b.extra);
+
+    m.dev_map = map_bytes(dev_map_);
+    m.dev_keys = vec_bytes(ordered_dev_keys_) + vec_bytes(dev_entries_);
+    m.index = hash_bytes(dev_hash_) + vec_bytes(dev_slots_) + hash_bytes(if_hash_) + vec_bytes(if_bases_) +
+              vec_bytes(if_rules_) + vec_bytes(if_digits_) + vec_bytes(seq_ifs_) + vec_bytes(block_fps_);
+    if (image_) m.image = image_->bytes().size();
+    m.arena = arena_.capacity();
+    m.arena_chunks = arena_.chunks();
+
+    // Built on first use by another thread maybe, only read once complete
+    if (materialized_done_.load(std::memory_order_acquire)) {
+        m.if_map = map_bytes(if_map_) + if_names_.capacity();
+    }
+    if (relations_done_.load(std::memory_order_acquire)) {
+        m.relations = map_bytes(rel_.if_seq) + rel_.names.capacity();
+        for (const RelationMap* map : { &rel_.zone_devs, &rel_.zone_ifs, &rel_.dat_ifs, &rel_.dev_ifs }) {
+            m.relations += map_bytes(*map);
+            for (const auto& kv : *map) m.relations += vec_bytes(kv.second);
+        }
+    }
+    return m;
+}
+
+std::shared_ptr<L1Snapshot> L1Snapshot::compacted() const {
+    if (image_) return nullptr;
+
+    // Every string, table and hash lands in one region; the parsed maps and
+    // the string pool go away with this snapshot
+    L1ImageWriter w;
+    add_to_image(w);
+    auto image = L1Image::from_bytes(w.build(src_path_, src_st_));
+    if (!image) return nullptr;
+
+    std::shared_ptr<L1Snapshot> snap(new L1Snapshot());
+    snap->image_ = std::move(image);
+    snap->compact_ = true;
+    snap->src_path_ = src_path_;
+    snap->src_st_ = src_st_;
+    snap->if_limits_ = if_limits_;
+    // A reload can still tell that nothing changed
+    snap->block_fps_ = block_fps_;
+#ifdef L1_ENABLE_STATS
+    snap->load_stats_ = load_stats_;
+#endif
+    return snap;
+}
+
+L1MemUsage L1Parser::memory_usage() const {
+    return snapshot()->memory_usage();
+}
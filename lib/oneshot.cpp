@@ -0,0 +1,207 @@
+#include "l1parser.hpp"
+#include "l1dat.hpp"
+#include "../utils/fileview.hpp"
+#include "../utils/stringutils.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * One-shot lookups for l1util. A single command needs one value of one
+ * band, so instead of building a snapshot (every entry, every split
+ * property, interface rules and hashes) the scan keeps, per INDEX block,
+ * only the chip name, the *_ifname stems and the requested property, all
+ * as views into the text. The band is then located the way process_block()
+ * numbers devices and only its field of the requested property is split.
+ *
+ * Lines of a block may appear anywhere and later ones win, so every line is
+ * still tokenized; what is skipped is everything done after tokenizing.
+ */
+
+namespace {
+
+// The properties of one block the scan keeps
+struct ScanBlock {
+    std::optional<std::string_view> chip, main_if, want;
+    std::optional<std::string_view> stems[std::size(L1_IF_KEYS)];  // L1_IF_KEYS order, main_ifname unused
+};
+
+// One band, in creation order
+struct ScanBand {
+    size_t raw_idx, main_idx, band;
+    std::string_view main_if;
+    const ScanBlock* block;
+};
+
+// Field n of a ';' list, trimmed, as utils::split(list, ';', true)[n]
+std::optional<std::string_view> nth_field(std::string_view list, size_t n) {
+    if (list.empty()) return std::nullopt;
+    size_t begin = 0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t semi = utils::scan_for(list, begin, ';');
+        if (semi == std::string_view::npos) return std::nullopt;
+        begin = semi + 1;
+    }
+    size_t end = utils::scan_for(list, begin, ';');
+    if (end == std::string_view::npos) end = list.size();
+    return utils::trim(list.substr(begin, end - begin));
+}
+
+// Stem of an interface key of a band, defaults as in create_and_map_entry()
+std::string if_stem(const ScanBand& b, size_t slot) {
+    L1Key k = L1_IF_KEYS[slot];
+    if (k == L1Key::main_ifname) return std::string(b.main_if);
+    if (b.block->stems[slot]) {
+        auto val = nth_field(*b.block->stems[slot], b.band);
+        if (val && !val->empty()) return std::string(*val);
+    }
+    if (k == L1Key::ext_ifname) return std::string(b.main_if) + "_";
+    const char* prefix = k == L1Key::apcli_ifname ? "apcli" : k == L1Key::wds_ifname ? "wds" : "mesh";
+    return prefix + std::to_string(b.raw_idx + 1) + "_";
+}
+
+// Property key of a band, exactly as the entry would hold it; block_prop
+// for keys every band shares (L1Snapshot::is_block_prop())
+std::optional<std::string> band_prop(const ScanBand& b, std::string_view key, bool block_prop) {
+    for (size_t slot = 0; slot < std::size(L1_IF_KEYS); ++slot) {
+        if (key == L1_KEY_NAMES[(size_t)L1_IF_KEYS[slot]]) return if_stem(b, slot);
+    }
+    if (key == "subidx") return std::to_string(b.band + 1);
+    if (key == "mainidx") return std::to_string(b.main_idx);
+    if (!b.block->want) return std::nullopt;
+    if (block_prop) return std::string(*b.block->want);
+    return std::string(nth_field(*b.block->want, b.band).value_or(std::string_view()));
+}
+
+// "MT7981_1_2" -> { "MT7981", 1, 2 }, names as process_block() builds them
+bool split_dev_key(std::string_view dev, std::string_view& chip, size_t& main_idx, size_t& sub_idx) {
+    auto number = [](std::string_view s, size_t& out) {
+        auto v = l1_if_suffix(s);
+        if (!v || *v == 0) return false;
+        out = (size_t)*v;
+        return true;
+    };
+    size_t last = dev.rfind('_');
+    if (last == std::string_view::npos || last == 0) return false;
+    size_t mid = dev.rfind('_', last - 1);
+    if (mid == std::string_view::npos) return false;
+    chip = dev.substr(0, mid);
+    return number(dev.substr(mid + 1, last - mid - 1), main_idx) && number(dev.substr(last + 1), sub_idx);
+}
+
+} // namespace
+
+std::optional<L1Reply> L1Snapshot::scan_query(std::string_view buf, const std::vector<std::string_view>& args,
+                                              const L1IfLimits& limits) {
+    // Commands covered and what they look up: a device or an interface, and
+    // the property; datget reads profile_path, then the .dat file
+    if (args.empty()) return std::nullopt;
+    std::string_view cmd = args[0], name, key;
+    bool by_if = true;
+    if (cmd == "get" && args.size() == 3) {
+        by_if = false;
+        name = args[1];
+        key = args[2];
+    } else if (cmd == "getif" && args.size() == 3) {
+        name = args[1];
+        key = args[2];
+    } else if (cmd == "datget" && args.size() == 3) {
+        name = args[1];
+        key = L1_KEY_NAMES[(size_t)L1Key::profile_path];
+    } else if (args.size() == 2 && (cmd == "if2zone" || cmd == "if2dat" || cmd == "if2dbdcidx")) {
+        name = args[1];
+        key = cmd == "if2zone" ? L1_KEY_NAMES[(size_t)L1Key::nvram_zone]
+            : cmd == "if2dat"  ? L1_KEY_NAMES[(size_t)L1Key::profile_path]
+                               : L1_KEY_NAMES[(size_t)L1Key::subidx];
+    } else {
+        return std::nullopt;
+    }
+
+    std::string_view chip;
+    size_t main_idx = 0, sub_idx = 0;
+    if (!by_if && !split_dev_key(name, chip, main_idx, sub_idx)) return L1Reply{ L1Status::NotFound, "" };
+
+    std::map<size_t, ScanBlock> blocks;
+    utils::for_each_kv_line(buf, true, [&](std::string_view k, std::string_view val) {
+        auto res = parse_index_key(k);
+        if (!res) return;
+        std::string_view prop = res->second;
+        bool wanted = prop == key;
+        bool is_chip = prop == "INDEX", is_main = prop == "main_ifname";
+        // Stems also give the value of ext_ifname etc. for a device
+        size_t slot = std::size(L1_IF_KEYS);
+        for (size_t i = 1; i < std::size(L1_IF_KEYS) && !is_main; ++i) {
+            if (prop == L1_KEY_NAMES[(size_t)L1_IF_KEYS[i]]) slot = i;
+        }
+        if (!wanted && !is_chip && !is_main && slot == std::size(L1_IF_KEYS)) return;
+        ScanBlock& b = blocks[res->first];
+        if (wanted) b.want = val;
+        if (is_chip) b.chip = val;
+        if (is_main) b.main_if = val;
+        if (slot < std::size(L1_IF_KEYS)) b.stems[slot] = val;
+    });
+
+    // Number bands as process_block() does, stopping at the device asked for
+    std::vector<ScanBand> bands;
+    std::unordered_map<std::string_view, size_t> chipset_counter;
+    std::optional<ScanBand> found;
+    for (const auto& [raw_idx, b] : blocks) {
+        if (!b.chip) continue;
+        size_t idx = ++chipset_counter[*b.chip];
+        if (!b.main_if) continue;
+        auto main_ifs = utils::split(*b.main_if, ';', false);
+        if (!by_if) {
+            if (*b.chip != chip || idx != main_idx) continue;
+            if (sub_idx <= main_ifs.size()) found = ScanBand{ raw_idx, idx, sub_idx - 1, main_ifs[sub_idx - 1], &b };
+            break;
+        }
+        for (size_t i = 0; i < main_ifs.size(); ++i) bands.push_back({ raw_idx, idx, i, main_ifs[i], &b });
+    }
+
+    if (by_if) {
+        // Rules of the name's base only, newest band first, resolved like a
+        // snapshot resolves them (l1_resolve_if)
+        struct Candidate {
+            L1IfRule rule;
+            std::string digits;
+        };
+        std::string_view base = l1_if_split(name).first;
+        std::vector<Candidate> rules;
+        for (size_t order = bands.size(); order-- > 0;) {
+            for (size_t slot = 0; slot < std::size(L1_IF_KEYS); ++slot) {
+                std::string stem = if_stem(bands[order], slot);
+                auto [stem_base, digits] = l1_if_split(stem);
+                if (stem_base != base) continue;
+                rules.push_back({ { (uint32_t)order, (uint32_t)order, (uint32_t)L1_IF_KEYS[slot] }, std::string(digits) });
+            }
+        }
+        uint32_t dev = l1_resolve_if(name, limits, [&](std::string_view, auto f) {
+            for (const auto& c : rules) {
+                if (f(c.rule, c.digits)) return;
+            }
+        });
+        if (dev != UINT32_MAX) found = bands[dev];
+    }
+
+    if (!found) return L1Reply{ L1Status::NotFound, "" };
+    auto val = band_prop(*found, key, is_block_prop(key));
+    if (!val) return L1Reply{ L1Status::NotFound, "" };
+    if (cmd == "datget") {
+        auto dat = val->empty() ? nullptr : L1DatCache::instance().get(*val);
+        auto dat_val = dat ? dat->get(args[2]) : std::nullopt;
+        if (!dat_val) return L1Reply{ L1Status::NotFound, "" };
+        return L1Reply{ L1Status::Ok, std::string(*dat_val) };
+    }
+    return L1Reply{ L1Status::Ok, std::move(*val) };
+}
+
+std::optional<L1Reply> L1Parser::query_file(const std::string& path, const std::vector<std::string_view>& args,
+                                            const L1IfLimits& limits) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+    struct stat st;
+    utils::FileView file;
+    bool mapped = fstat(fd, &st) == 0 && file.open(fd, st);
+    close(fd);
+    if (!mapped) return std::nullopt;
+    return L1Snapshot::scan_query(file.data(), args, limits);
+}
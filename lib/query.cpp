@@ -0,0 +1,119 @@
+#include "l1parser.hpp"
+
+static L1Reply scalar_reply(std::optional<std::string> res) {
+    if (res.has_value()) return { L1Status::Ok, std::move(res.value()) };
+    return { L1Status::NotFound, "" };
+}
+
+template <typename T>
+static L1Reply list_reply(const std::vector<T>& vec) {
+    std::string joined;
+    for (size_t i = 0; i < vec.size(); ++i) {
+        if (i) joined += ' ';
+        joined += vec[i];
+    }
+    return { L1Status::Ok, joined };
+}
+
+L1Reply L1Snapshot::query(const std::vector<std::string_view>& args) const {
+    if (args.empty()) return { L1Status::BadRequest, "" };
+
+    std::string_view cmd = args[0];
+    auto arg = [&](size_t i) { return std::string(args[i]); };
+
+    if (cmd == "list") {
+        return list_reply(list_devs());
+    }
+    else if (cmd == "get") {
+        if (args.size() != 3) return { L1Status::BadRequest, "" };
+        return scalar_reply(get_prop(arg(1), arg(2)));
+    }
+    else if (cmd == "if2zone") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return scalar_reply(if2zone(arg(1)));
+    }
+    else if (cmd == "if2dat") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return scalar_reply(if2dat(arg(1)));
+    }
+    else if (cmd == "datget") {
+        if (args.size() != 3) return { L1Status::BadRequest, "" };
+        return scalar_reply(dat_get(arg(1), arg(2)));
+    }
+    else if (cmd == "zone2if") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return list_reply(zone2if(arg(1)));
+    }
+    else if (cmd == "zone2devs") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return list_reply(zone2devs(args[1]));
+    }
+    else if (cmd == "zone2ifs") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return list_reply(zone2ifs(args[1]));
+    }
+    else if (cmd == "dat2ifs") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return list_reply(dat2ifs(args[1]));
+    }
+    else if (cmd == "dev2ifs") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return list_reply(dev2ifs(args[1]));
+    }
+    else if (cmd == "if2dbdcidx") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        return scalar_reply(if2dbdcidx(arg(1)));
+    }
+    else if (cmd == "getif") {
+        if (args.size() != 3) return { L1Status::BadRequest, "" };
+        return scalar_reply(get_if_prop(arg(1), arg(2)));
+    }
+    else if (cmd == "idx2if") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        try {
+            int idx = std::stoi(arg(1));
+            return scalar_reply(idx2if(idx));
+        } catch (...) {
+            return { L1Status::BadRequest, "Invalid index number" };
+        }
+    }
+    else if (cmd == "idxtable") {
+        if (args.size() != 1) return { L1Status::BadRequest, "" };
+        return list_reply(idx_table());
+    }
+    else if (cmd == "if2idx") {
+        if (args.size() != 2) return { L1Status::BadRequest, "" };
+        auto idx = if2idx(args[1]);
+        return scalar_reply(idx ? std::optional<std::string>(std::to_string(*idx)) : std::nullopt);
+    }
+    return { L1Status::BadRequest, "" };
+}
+
+std::string L1Reply::to_line() const {
+    switch (status) {
+    case L1Status::Ok:       return "OK " + value;
+    case L1Status::NotFound: return "NONE";
+    default:                 return value.empty() ? "ERR" : "ERR " + value;
+    }
+}
+
+L1Reply L1Reply::from_line(std::string_view line) {
+    if (line.compare(0, 3, "OK ") == 0) return { L1Status::Ok, std::string(line.substr(3)) };
+    if (line == "NONE") return { L1Status::NotFound, "" };
+    if (line.compare(0, 4, "ERR ") == 0) return { L1Status::BadRequest, std::string(line.substr(4)) };
+    return { L1Status::BadRequest, "" };
+}
+
+L1Reply L1Snapshot::query(std::string_view line) const {
+    std::vector<std::string_view> args;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t start = line.find_first_not_of(" \t\r\n", pos);
+        if (start == std::string_view::npos) break;
+        size_t end = line.find_first_of(" \t\r\n", start);
+        if (end == std::string_view::npos) end = line.size();
+        args.push_back(line.substr(start, end - start));
+        pos = end;
+    }
+    return query(args);
+}
@@ -0,0 +1,327 @@
+#include "l1parser.hpp"
+#include "l1dat.hpp"
+#include "l1watch.hpp"
+#include <thread>
+
+/*
+ * Snapshot publication. Lookups pin the current snapshot for the duration of
+ * one call through ReadGuard; no lock is taken on the read side. Every
+ * (re)load builds a complete L1Snapshot off to the side and publishes it with
+ * a single pointer swap, so a lookup sees either the old or the new profile,
+ * never a partially built one.
+ */
+class L1Parser::ReadGuard {
+public:
+    explicit ReadGuard(const L1Parser& p) {
+        // Register in the current epoch; retry if a writer flipped it meanwhile
+        for (;;) {
+            unsigned e = p.epoch_.load();
+            slot_ = &p.readers_[e & 1];
+            slot_->fetch_add(1);
+            if (p.epoch_.load() == e) break;
+            slot_->fetch_sub(1, std::memory_order_release);
+        }
+        snap_ = p.current_.load();
+    }
+    ~ReadGuard() { slot_->fetch_sub(1, std::memory_order_release); }
+
+    const L1Snapshot* operator->() const { return snap_; }
+    const L1Snapshot& operator*() const { return *snap_; }
+
+private:
+    std::atomic<long>* slot_;
+    const L1Snapshot* snap_;
+};
+
+L1Parser::L1Parser() : current_(nullptr), epoch_(0), readers_{ { 0 }, { 0 } } {
+    // Start from an empty profile so lookups never see a null snapshot
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    publish(new_snapshot());
+#ifdef L1_COMPACT_DEFAULT
+    compact_ = true;
+#endif
+}
+
+L1Parser::~L1Parser() {
+    // Stop the watcher first, it publishes into this object
+    watcher_.reset();
+}
+
+// Caller holds write_mutex_, like for publish()
+std::shared_ptr<L1Snapshot> L1Parser::new_snapshot() const {
+    std::shared_ptr<L1Snapshot> snap(new L1Snapshot());
+    snap->if_limits_ = if_limits_;
+    snap->arena_.lend(arena_buf_);
+    return snap;
+}
+
+// Caller holds write_mutex_, which also keeps concurrent (re)loads in order
+void L1Parser::publish(std::shared_ptr<L1Snapshot> snap) {
+    // Compact mode keeps the packed image only. If it cannot be built the
+    // parsed snapshot answers the same, just with more memory.
+    if (compact_) {
+        if (auto packed = snap->compacted()) {
+            // Only materialize() allocates from its arena, so it can still
+            // get the buffer once the parsed snapshot is gone
+            packed->arena_.lend(arena_buf_);
+            snap = std::move(packed);
+        }
+    }
+    current_.store(snap.get());
+    unsigned old_epoch = epoch_.fetch_add(1);
+
+    // Grace period: whoever registered before the flip may still be reading
+    // the previous snapshot. Lookups are short, spinning politely is enough.
+    while (readers_[old_epoch & 1].load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+    owner_ = std::move(snap);
+}
+
+// incremental: the file is a new revision of the current snapshot's, which
+// stays in place if every INDEX block parses the same
+bool L1Parser::load_locked(const std::string& path, bool use_cache, L1Diff* diff, bool incremental) {
+    // The .dat files the profile names are read on demand, not with it; a
+    // (re)load is when lookups expect them to be current again
+    L1DatCache::instance().revalidate();
+    std::shared_ptr<L1Snapshot> snap = new_snapshot();
+    // owner_ cannot change while write_mutex_ is held
+    if (incremental) snap->base_ = owner_.get();
+    bool ok = snap->load(path, use_cache);
+    snap->base_ = nullptr;
+    L1_STAT(stats_.record_load(ok));
+    if (!ok) return false;
+    if (snap->unchanged_) {
+        if (diff) *diff = L1Diff();
+        return true;
+    }
+    if (diff) *diff = snap->diff(*owner_);
+    publish(std::move(snap));
+    path_ = path;
+    use_cache_ = use_cache;
+    return true;
+}
+
+bool L1Parser::load(const std::string path, bool use_cache) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return load_locked(path, use_cache);
+}
+
+bool L1Parser::load_from_fd(int fd) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::shared_ptr<L1Snapshot> snap = new_snapshot();
+    bool ok = snap->load_from_fd(fd);
+    L1_STAT(stats_.record_load(ok));
+    if (!ok) return false;
+    publish(std::move(snap));
+    return true;
+}
+
+bool L1Parser::load_from_buffer(std::string_view buf) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::shared_ptr<L1Snapshot> snap = new_snapshot();
+    bool ok = snap->load_from_buffer(buf);
+    L1_STAT(stats_.record_load(ok));
+    if (!ok) return false;
+    publish(std::move(snap));
+    return true;
+}
+
+bool L1Parser::reload(L1Diff* diff) {
+    // Same lock for the whole rebuild: a slow reload cannot publish an older
+    // file revision over a newer one
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (path_.empty()) return false;
+    return load_locked(path_, use_cache_, diff, true);
+}
+
+bool L1Parser::set_if_limits(const L1IfLimits& limits) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if_limits_ = limits;
+    // Snapshots never change, the file is loaded again with the new limits
+    if (path_.empty()) return true;
+    return load_locked(path_, use_cache_);
+}
+
+bool L1Parser::set_compact(bool compact) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    compact_ = compact;
+    // Same as new limits: a file is loaded again in the new layout
+    if (path_.empty()) return true;
+    return load_locked(path_, use_cache_);
+}
+
+void L1Parser::set_arena(void* buf, size_t size) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    // Snapshots that claimed the previous buffer keep it until released
+    arena_buf_ = buf ? std::make_shared<utils::ArenaBuffer>(buf, size) : nullptr;
+}
+
+bool L1Parser::watch() {
+    if (watcher_) return true;
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        path = path_;
+    }
+    if (path.empty()) return false;
+
+    // A failed reload keeps the previous snapshot, there is nobody to tell
+    watcher_ = L1Watcher::start(path, [this]() { reload(); });
+    if (!watcher_) return false;
+    // Keep the .dat indexes as current as the profile
+    L1DatCache::instance().watch();
+    return true;
+}
+
+void L1Parser::unwatch() {
+    watcher_.reset();
+}
+
+std::shared_ptr<const L1Snapshot> L1Parser::snapshot() const {
+    ReadGuard snap(*this);
+    // owner_ cannot drop this snapshot while the guard is held
+    return snap->shared_from_this();
+}
+
+L1Stats L1Parser::stats() const {
+    L1Stats out;
+#ifdef L1_ENABLE_STATS
+    stats_.fill(out);
+    ReadGuard snap(*this);
+    out.last_load = snap->load_stats();
+#endif
+    return out;
+}
+
+bool L1Parser::compile(const std::string& out_path) const {
+    ReadGuard snap(*this);
+    return snap->compile(out_path);
+}
+
+bool L1Parser::export_to(int fd, L1ExportFormat format) const {
+    ReadGuard snap(*this);
+    return snap->export_to(fd, format);
+}
+
+bool L1Parser::from_image() const {
+    ReadGuard snap(*this);
+    return snap->from_image();
+}
+
+const std::pmr::unordered_map<std::string_view, L1Entry>& L1Parser::get_all() const {
+    ReadGuard snap(*this);
+    return snap->get_all();
+}
+
+const std::unordered_map<std::string_view, const L1Entry*>& L1Parser::get_if_map() const {
+    ReadGuard snap(*this);
+    return snap->get_if_map();
+}
+
+std::optional<std::string> L1Parser::get_prop(const std::string& dev, const std::string& key) const {
+    L1_STAT_CALL(stats_, L1Api::get_prop);
+    ReadGuard snap(*this);
+    return snap->get_prop(dev, key);
+}
+
+std::vector<std::string> L1Parser::list_devs() const {
+    L1_STAT_CALL(stats_, L1Api::list_devs);
+    ReadGuard snap(*this);
+    return snap->list_devs();
+}
+
+std::optional<std::string> L1Parser::get_if_prop(const std::string& ifname, const std::string& key) const {
+    L1_STAT_CALL(stats_, L1Api::get_if_prop);
+    ReadGuard snap(*this);
+    return snap->get_if_prop(ifname, key);
+}
+
+std::optional<std::string> L1Parser::if2zone(const std::string& ifname) const {
+    L1_STAT_CALL(stats_, L1Api::if2zone);
+    ReadGuard snap(*this);
+    return snap->if2zone(ifname);
+}
+
+std::optional<std::string> L1Parser::if2dat(const std::string& ifname) const {
+    L1_STAT_CALL(stats_, L1Api::if2dat);
+    ReadGuard snap(*this);
+    return snap->if2dat(ifname);
+}
+
+std::optional<std::string> L1Parser::dat_get(const std::string& ifname, const std::string& key) const {
+    L1_STAT_CALL(stats_, L1Api::dat_get);
+    ReadGuard snap(*this);
+    return snap->dat_get(ifname, key);
+}
+
+std::optional<std::string> L1Parser::if2dbdcidx(const std::string& ifname) const {
+    L1_STAT_CALL(stats_, L1Api::if2dbdcidx);
+    ReadGuard snap(*this);
+    return snap->if2dbdcidx(ifname);
+}
+
+std::vector<std::string> L1Parser::zone2if(const std::string& zone) const {
+    L1_STAT_CALL(stats_, L1Api::zone2if);
+    ReadGuard snap(*this);
+    return snap->zone2if(zone);
+}
+
+std::optional<std::string> L1Parser::idx2if(size_t target) const {
+    L1_STAT_CALL(stats_, L1Api::idx2if);
+    ReadGuard snap(*this);
+    return snap->idx2if(target);
+}
+
+std::vector<std::string> L1Parser::idx_table() const {
+    L1_STAT_CALL(stats_, L1Api::idx_table);
+    ReadGuard snap(*this);
+    return snap->idx_table();
+}
+
+std::optional<size_t> L1Parser::if2idx(const std::string& ifname) const {
+    L1_STAT_CALL(stats_, L1Api::if2idx);
+    ReadGuard snap(*this);
+    return snap->if2idx(ifname);
+}
+
+L1Reply L1Parser::query(const std::vector<std::string_view>& args) const {
+    L1_STAT_CALL(stats_, L1Api::query);
+    ReadGuard snap(*this);
+    return snap->query(args);
+}
+
+L1Reply L1Parser::query(std::string_view line) const {
+    L1_STAT_CALL(stats_, L1Api::query);
+    ReadGuard snap(*this);
+    return snap->query(line);
+}
+
+static std::vector<std::string> to_strings(const std::vector<std::string_view>& views) {
+    return std::vector<std::string>(views.begin(), views.end());
+}
+
+std::vector<std::string> L1Parser::zone2devs(const std::string& zone) const {
+    L1_STAT_CALL(stats_, L1Api::zone2devs);
+    ReadGuard snap(*this);
+    return to_strings(snap->zone2devs(zone));
+}
+
+std::vector<std::string> L1Parser::zone2ifs(const std::string& zone) const {
+    L1_STAT_CALL(stats_, L1Api::zone2ifs);
+    ReadGuard snap(*this);
+    return to_strings(snap->zone2ifs(zone));
+}
+
+std::vector<std::string> L1Parser::dat2ifs(const std::string& dat_path) const {
+    L1_STAT_CALL(stats_, L1Api::dat2ifs);
+    ReadGuard snap(*this);
+    return to_strings(snap->dat2ifs(dat_path));
+}
+
+std::vector<std::string> L1Parser::dev2ifs(const std::string& dev) const {
+    L1_STAT_CALL(stats_, L1Api::dev2ifs);
+    ReadGuard snap(*this);
+    return to_strings(snap->dev2ifs(dev));
+}
@@ -0,0 +1,81 @@
+#include "l1stats.hpp"
+#include "../utils/json.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+
+static void append(std::string& out, const char* fmt, uint64_t v) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), fmt, v);
+    out += buf;
+}
+
+std::string l1_stats_json(const L1Stats& stats) {
+    std::string out = "{\"enabled\": ";
+    out += stats.enabled ? "true" : "false";
+    append(out, ", \"loads\": %" PRIu64, stats.loads);
+    append(out, ", \"load_failures\": %" PRIu64, stats.load_failures);
+
+    const L1LoadStats& l = stats.last_load;
+    out += ", \"last_load\": {\"from_image\": ";
+    out += l.from_image ? "true" : "false";
+    append(out, ", \"bytes\": %" PRIu64, l.bytes);
+    append(out, ", \"blocks\": %" PRIu64, l.blocks);
+    append(out, ", \"blocks_reused\": %" PRIu64, l.blocks_reused);
+    append(out, ", \"entries\": %" PRIu64, l.entries);
+    append(out, ", \"main_ifs\": %" PRIu64, l.main_ifs);
+    append(out, ", \"if_rules\": %" PRIu64, l.if_rules);
+    uint64_t total = 0;
+    out += ", \"phase_ns\": {";
+    for (size_t i = 0; i < L1_LOAD_PHASE_COUNT; ++i) {
+        if (i) out += ", ";
+        utils::append_json_string(out, l1_load_phase_name((L1LoadPhase)i));
+        append(out, ": %" PRIu64, l.phase_ns[i]);
+        total += l.phase_ns[i];
+    }
+    append(out, "}, \"total_ns\": %" PRIu64 "}", total);
+
+    // Histogram buckets are keyed by their upper bound, "inf" for the last
+    out += ", \"api\": {";
+    bool first = true;
+    for (size_t i = 0; i < L1_API_COUNT; ++i) {
+        const L1ApiStats& a = stats.api[i];
+        if (a.calls == 0) continue;
+        if (!first) out += ", ";
+        first = false;
+        utils::append_json_string(out, l1_api_name((L1Api)i));
+        append(out, ": {\"calls\": %" PRIu64, a.calls);
+        append(out, ", \"total_ns\": %" PRIu64, a.total_ns);
+        out += ", \"hist\": {";
+        bool first_bucket = true;
+        for (size_t b = 0; b < L1_STATS_BUCKETS; ++b) {
+            if (a.hist[b] == 0) continue;
+            if (!first_bucket) out += ", ";
+            first_bucket = false;
+            char bucket[32] = "inf";
+            if (b + 1 < L1_STATS_BUCKETS) snprintf(bucket, sizeof(bucket), "lt_%" PRIu64 "ns", l1_stats_bucket_limit_ns(b));
+            utils::append_json_string(out, bucket);
+            append(out, ": %" PRIu64, a.hist[b]);
+        }
+        out += "}}";
+    }
+    out += "}}";
+    return out;
+}
+
+std::string l1_mem_json(const L1MemUsage& mem) {
+    std::string out = "{\"compact\": ";
+    out += mem.compact ? "true" : "false";
+    append(out, ", \"strings\": %" PRIu64, mem.strings);
+    append(out, ", \"blocks\": %" PRIu64, mem.blocks);
+    append(out, ", \"dev_map\": %" PRIu64, mem.dev_map);
+    append(out, ", \"dev_keys\": %" PRIu64, mem.dev_keys);
+    append(out, ", \"index\": %" PRIu64, mem.index);
+    append(out, ", \"image\": %" PRIu64, mem.image);
+    append(out, ", \"if_map\": %" PRIu64, mem.if_map);
+    append(out, ", \"relations\": %" PRIu64, mem.relations);
+    append(out, ", \"total\": %" PRIu64, mem.total());
+    append(out, ", \"arena\": %" PRIu64, mem.arena);
+    append(out, ", \"arena_chunks\": %" PRIu64 "}", mem.arena_chunks);
+    return out;
+}
@@ -0,0 +1,319 @@
+#include "l1parser.hpp"
+#include "l1dat.hpp"
+#include "../utils/fileview.hpp"
+#include "../utils/stringutils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Write-back of staged edits. A file is rewritten by splicing new values
+ * into the text as it is on disk at commit time: only the value of an
+ * edited line changes, and keys a block or .dat file does not have yet are
+ * added as new lines (after the block's last line, or at the end of the
+ * .dat file). The result replaces the file through a temp file, fsync()
+ * and rename(), so readers see the old or the new file, never a mix.
+ */
+
+namespace {
+
+struct Splice {
+    size_t begin, end;  // replaced range of the original text
+    std::string text;
+};
+
+std::string apply_splices(std::string_view buf, std::vector<Splice>& splices) {
+    // Stable: lines inserted at the same place keep their order
+    std::stable_sort(splices.begin(), splices.end(), [](const Splice& a, const Splice& b) { return a.begin < b.begin; });
+    std::string out;
+    out.reserve(buf.size() + 256);
+    size_t pos = 0;
+    for (const auto& s : splices) {
+        out.append(buf.substr(pos, s.begin - pos));
+        out += s.text;
+        pos = s.end;
+    }
+    out.append(buf.substr(pos));
+    return out;
+}
+
+// Where the value of a tokenized line sits in buf. for_each_kv_line() hands
+// out views into buf, except for empty values which have no position.
+std::pair<size_t, size_t> value_span(std::string_view buf, std::string_view key, std::string_view val) {
+    if (!val.empty()) {
+        size_t begin = (size_t)(val.data() - buf.data());
+        return { begin, begin + val.size() };
+    }
+    size_t eq = buf.find('=', (size_t)(key.data() - buf.data()) + key.size());
+    return { eq + 1, eq + 1 };
+}
+
+// Past the '\n' of the line holding pos
+size_t line_end(std::string_view buf, size_t pos) {
+    size_t nl = utils::scan_for(buf, pos, '\n');
+    return nl == std::string_view::npos ? buf.size() : nl + 1;
+}
+
+// Replace field band of a ';' separated list, padding it with empty fields
+std::string set_field(std::string_view list, size_t band, std::string_view value) {
+    size_t begin = 0;
+    for (size_t i = 0; i < band; ++i) {
+        size_t semi = list.find(';', begin);
+        if (semi == std::string_view::npos) {
+            return std::string(list) + std::string(band - i, ';') + std::string(value);
+        }
+        begin = semi + 1;
+    }
+    size_t end = list.find(';', begin);
+    if (end == std::string_view::npos) end = list.size();
+    std::string out(list.substr(0, begin));
+    out += value;
+    out += list.substr(end);
+    return out;
+}
+
+// Field of band in main_ifname: bands are its non-empty fields only
+size_t main_if_field(std::string_view list, size_t band) {
+    size_t field = 0;
+    for (std::string_view name : utils::split(list, ';', true)) {
+        if (!name.empty() && band-- == 0) break;
+        ++field;
+    }
+    return field;
+}
+
+std::string rewrite_dat(std::string_view buf, const std::map<std::string, std::string, std::less<>>& edits) {
+    std::vector<Splice> splices;
+    std::unordered_set<std::string_view> done;
+    // Only the first occurrence counts (see L1DatFile), so only it changes
+    utils::for_each_kv_line(buf, false, [&](std::string_view key, std::string_view val) {
+        auto it = edits.find(key);
+        if (it == edits.end() || !done.insert(it->first).second) return;
+        auto span = value_span(buf, key, val);
+        splices.push_back({ span.first, span.second, it->second });
+    });
+
+    std::string tail;
+    for (const auto& [key, val] : edits) {
+        if (done.count(key)) continue;
+        tail += key;
+        tail += '=';
+        tail += val;
+        tail += '\n';
+    }
+    if (!tail.empty()) {
+        if (!buf.empty() && buf.back() != '\n') tail.insert(tail.begin(), '\n');
+        splices.push_back({ buf.size(), buf.size(), std::move(tail) });
+    }
+    return apply_splices(buf, splices);
+}
+
+/*
+ * Read path (following symlinks), let rewrite turn its text into out and
+ * replace the file with the result. The new file keeps the old one's mode;
+ * st receives its stat.
+ */
+template <typename Rewrite>
+bool rewrite_file(const std::string& path, std::string& out, struct stat& st, Rewrite rewrite) {
+    char* real = realpath(path.c_str(), nullptr);
+    if (!real) return false;
+    std::string real_path(real);
+    free(real);
+
+    int fd = ::open(real_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    utils::FileView file;
+    bool ok = fstat(fd, &st) == 0 && file.open(fd, st);
+    ::close(fd);
+    if (!ok || !rewrite(file.data(), out)) return false;
+
+    mode_t mode = st.st_mode & 07777;
+    std::string tmp_path = real_path + ".tmp." + std::to_string(getpid());
+    fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    if (fd < 0) return false;
+
+    const char* p = out.data();
+    size_t left = out.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+
+    // The data has to be on disk before the rename makes it the file
+    ok = left == 0 && fchmod(fd, mode) == 0 && fsync(fd) == 0 && fstat(fd, &st) == 0;
+    if (::close(fd) != 0) ok = false;
+    if (!ok || ::rename(tmp_path.c_str(), real_path.c_str()) != 0) {
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool valid_key(std::string_view key) {
+    return !key.empty() && key.find_first_of(" \t\r\n=#;") == std::string_view::npos;
+}
+
+} // namespace
+
+bool L1Parser::rewrite_profile(std::string_view buf, const StagedProps& edits, std::string& out) {
+    // Last line of each (block, property), as the parser would use it
+    struct Block {
+        std::unordered_map<std::string_view, std::pair<size_t, size_t>> spans;
+        std::unordered_map<std::string_view, std::string_view> props;
+        size_t end = 0;     // past the block's last line
+    };
+    std::map<size_t, Block> blocks;
+    utils::for_each_kv_line(buf, true, [&](std::string_view key, std::string_view val) {
+        auto res = L1Snapshot::parse_index_key(key);
+        if (!res) return;
+        Block& b = blocks[res->first];
+        auto span = value_span(buf, key, val);
+        b.spans[res->second] = span;
+        b.props[res->second] = val;
+        b.end = line_end(buf, span.second);
+    });
+
+    // Device keys as process_block() names them -> (raw index, band)
+    std::unordered_map<std::string, std::pair<size_t, size_t>> devs;
+    std::unordered_map<std::string_view, size_t> chipset_counter;
+    for (const auto& [raw_idx, b] : blocks) {
+        auto chip = b.props.find("INDEX");
+        if (chip == b.props.end()) continue;
+        size_t main_idx = ++chipset_counter[chip->second];
+        auto main_if = b.props.find("main_ifname");
+        if (main_if == b.props.end()) continue;
+        size_t bands = utils::split(main_if->second, ';', false).size();
+        for (size_t i = 0; i < bands; ++i) {
+            devs[std::string(chip->second) + "_" + std::to_string(main_idx) + "_" + std::to_string(i + 1)] = { raw_idx, i };
+        }
+    }
+
+    // New value of every touched line; several bands may share one
+    std::map<std::pair<size_t, std::string_view>, std::string> values;
+    for (const auto& [dev_key, value] : edits) {
+        auto dev = devs.find(dev_key.first);
+        if (dev == devs.end()) return false;
+        auto [raw_idx, band] = dev->second;
+        std::string_view key = dev_key.second;
+
+        auto it = values.find({ raw_idx, key });
+        if (it == values.end()) {
+            const Block& b = blocks.at(raw_idx);
+            auto cur = b.props.find(key);
+            it = values.emplace(std::make_pair(raw_idx, key),
+                                std::string(cur == b.props.end() ? std::string_view() : cur->second)).first;
+        }
+        if (L1Snapshot::is_block_prop(key)) it->second = value;
+        else if (key == "main_ifname") it->second = set_field(it->second, main_if_field(it->second, band), value);
+        else it->second = set_field(it->second, band, value);
+    }
+
+    std::vector<Splice> splices;
+    for (const auto& [line, value] : values) {
+        const Block& b = blocks.at(line.first);
+        auto span = b.spans.find(line.second);
+        if (span != b.spans.end()) {
+            splices.push_back({ span->second.first, span->second.second, value });
+            continue;
+        }
+        std::string text = "INDEX" + std::to_string(line.first) + "_" + std::string(line.second) + "=" + value + "\n";
+        if (b.end == buf.size() && !buf.empty() && buf.back() != '\n') text.insert(text.begin(), '\n');
+        splices.push_back({ b.end, b.end, std::move(text) });
+    }
+    out = apply_splices(buf, splices);
+    return true;
+}
+
+bool L1Parser::set_prop(const std::string& dev, const std::string& key, const std::string& value) {
+    // Device identity is derived from the block, not a property to set
+    if (!valid_key(key) || key == "INDEX" || key == "mainidx" || key == "subidx") return false;
+    if (value.find_first_of("\r\n#") != std::string::npos) return false;
+    if (!L1Snapshot::is_block_prop(key) && value.find(';') != std::string::npos) return false;
+    // An empty main_ifname field is no band, the band after it would take dev
+    if (key == "main_ifname" && utils::trim(value).empty()) return false;
+    if (!snapshot()->prop_view(dev, L1Key::INDEX)) return false;
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    staged_props_[{ dev, key }] = value;
+    return true;
+}
+
+bool L1Parser::set_dat(const std::string& ifname, const std::string& key, const std::string& value) {
+    if (!valid_key(key) || value.find_first_of("\r\n") != std::string::npos) return false;
+    auto path = snapshot()->if_prop_view(ifname, L1Key::profile_path);
+    if (!path || path->empty()) return false;
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    staged_dats_[std::string(*path)][key] = value;
+    return true;
+}
+
+bool L1Parser::commit() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    bool ok = true;
+
+    for (auto it = staged_dats_.begin(); it != staged_dats_.end();) {
+        std::string text;
+        struct stat st;
+        bool written = rewrite_file(it->first, text, st, [&](std::string_view buf, std::string& out) {
+            out = rewrite_dat(buf, it->second);
+            return true;
+        });
+        if (!written) {
+            ok = false;
+            ++it;
+            continue;
+        }
+        // Lookups get the new values without reading the file back
+        L1DatCache::instance().put(it->first, text, st);
+        it = staged_dats_.erase(it);
+    }
+
+    if (staged_props_.empty()) return ok;
+    if (path_.empty()) return false;
+
+    std::string text;
+    struct stat st;
+    bool written = rewrite_file(path_, text, st, [&](std::string_view buf, std::string& out) {
+        return rewrite_profile(buf, staged_props_, out);
+    });
+    if (!written) return false;
+    staged_props_.clear();
+
+    // The new snapshot comes from the text just written, on top of the
+    // current one: only the blocks the edits touched are split again, the
+    // others are copied (see reuse_block()). Its fingerprints are those of
+    // the renamed file, so a watcher reloading after the rename finds every
+    // block unchanged and keeps it.
+    std::shared_ptr<L1Snapshot> snap = new_snapshot();
+    // owner_ cannot change while write_mutex_ is held
+    snap->base_ = owner_.get();
+    bool parsed = snap->load_from_buffer(text);
+    snap->base_ = nullptr;
+    L1_STAT(stats_.record_load(parsed));
+    if (!parsed) return false;
+    // Every edit set the value already in place
+    if (snap->unchanged_) return ok;
+    snap->src_path_ = path_;
+    snap->src_st_ = st;
+    publish(snap);
+    // Keep the image of the default profile valid, it is rejected as soon
+    // as the source changes. Only an optimization, failing is fine.
+    if (use_cache_ && path_ == L1_DAT_PATH) snap->compile(L1_CACHE_PATH);
+    return ok;
+}
+
+void L1Parser::discard() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    staged_props_.clear();
+    staged_dats_.clear();
+}
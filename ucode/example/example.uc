@@ -21,6 +21,16 @@ if (length(devs) > 0) {
     print(dev + " -> main_ifname: " + val + "\n");
 }
 
+// getall: proxy that looks properties up on demand
+let all = ctx.getall();
+let first = all.get(all.list()[0]);
+if (first) print("main_ifname via getall: " + first.get("main_ifname") + "\n");
+
+// getall(true): the whole profile as one frozen object, shared between
+// calls until the profile is reloaded
+let tree = ctx.getall(true);
+printf("devices in tree: %d\n", length(keys(tree)));
+
 // if2zone
 let zone = ctx.if2zone("ra0");
 if (zone) print("ra0 zone: " + zone + "\n");
@@ -33,6 +43,10 @@ printf("if in zone dev1: %s\n", ifs);
 let dat = ctx.if2dat("ra0");
 if (dat) print("ra0 dat: " + dat + "\n");
 
+// dat_get: a key of that .dat file, indexed once and cached
+let channel = ctx.dat_get("ra0", "Channel");
+if (channel) print("ra0 Channel: " + channel + "\n");
+
 // idx2if, from 1
 // l1util idx2if <int>
 let ifname = ctx.idx2if(1);
@@ -45,8 +59,11 @@ ctx.close();
 /* results
 [ "MT7981_1_1", "MT7981_1_2" ]
 MT7981_1_1 -> main_ifname: ra0
+main_ifname via getall: ra0
+devices in tree: 2
 ra0 zone: dev1
 if in zone dev1: [ "ra0", "ra", "apcli", "wds", "mesh" ]
 ra0 dat: /etc/wireless/mediatek/mt7981.dbdc.b0.dat
+ra0 Channel: 36
 Index 1 is: ra0
 */
\ No newline at end of file
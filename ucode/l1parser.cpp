@@ -16,9 +16,32 @@ extern "C" {
 // hold cpp objects directly, use RAII
 struct L1Context {
     L1Parser inner;
+
+    // getall(true): frozen tree shared by every call until a reload
+    uc_value_t *tree = NULL;
+    std::shared_ptr<const L1Snapshot> tree_snap;
+
+    ~L1Context() { ucv_put(tree); }
+};
+
+/*
+ * getall() proxies. Both pin the snapshot they were created from and resolve
+ * properties only when asked, so a handler reading two fields pays for two
+ * lookups instead of a copy of the whole profile. Property views stay valid
+ * for as long as the proxy holds the snapshot.
+ */
+struct L1DevicesProxy {
+    std::shared_ptr<const L1Snapshot> snap;
+};
+
+struct L1DeviceProxy {
+    std::shared_ptr<const L1Snapshot> snap;
+    std::string_view dev;
 };
 
 static uc_resource_type_t *l1_ctx_type;
+static uc_resource_type_t *l1_devs_type;
+static uc_resource_type_t *l1_dev_type;
 
 #define err_return(err) do { \
     uc_vm_registry_set(vm, "l1parser.last_error", ucv_int64_new(err)); \
@@ -34,6 +57,14 @@ static void close_ctx(void *ud) {
     }
 }
 
+static void close_devs(void *ud) {
+    delete reinterpret_cast<L1DevicesProxy *>(ud);
+}
+
+static void close_dev(void *ud) {
+    delete reinterpret_cast<L1DeviceProxy *>(ud);
+}
+
 /* --- Helper: Convert std::vector<std::string> to ucode Array --- */
 static uc_value_t *
 vector_to_uc_array(uc_vm_t *vm, const std::vector<std::string>& vec) {
@@ -44,14 +75,14 @@ vector_to_uc_array(uc_vm_t *vm, const std::vector<std::string>& vec) {
     return arr;
 }
 
-/* --- Helper: Convert std::unordered_map<std::string, std::string> to ucode Object --- */
+/* --- Helper: Convert L1Entry props to ucode Object --- */
 static uc_value_t *
-map_to_uc_object(uc_vm_t *vm, const std::unordered_map<std::string, std::string>& map) {
+entry_to_uc_object(uc_vm_t *vm, const L1Entry& entry) {
     uc_value_t *obj = ucv_object_new(vm);
-    for (const auto &kv : map) {
-        // put k-v pairs into a ucode object 
-        ucv_object_add(obj, kv.first.c_str(), ucv_string_new(kv.second.c_str()));
-    }
+    entry.for_each([&](std::string_view k, std::string_view v) {
+        // put k-v pairs into a ucode object, key names are NUL-terminated
+        ucv_object_add(obj, k.data(), ucv_string_new_length(v.data(), v.size()));
+    });
     return obj;
 }
 
@@ -73,30 +104,138 @@ uc_l1_get(uc_vm_t *vm, size_t nargs)
     }));
 }
 
+/* Plain { dev: { key: value } } object of a whole snapshot */
+static uc_value_t *
+snapshot_to_uc_object(uc_vm_t *vm, const L1Snapshot& snap, bool freeze) {
+    // root object
+    uc_value_t *root = ucv_object_new(vm);
+
+    // every k-v pairs in all dev maps
+    // here k for dev name, v for L1Entry
+    for (const auto& kv : snap.get_all()) {
+        std::string_view dev_key = kv.first;        // e.g. "MT7981_1_1"
+        const L1Entry& entry = kv.second;
+
+        // current dev props
+        uc_value_t *child_obj = entry_to_uc_object(vm, entry);
+        if (freeze) ucv_set_constant(child_obj, true);
+
+        // root = { dev_key: {dev_props} }
+        ucv_object_add(root, dev_key.data(), child_obj);
+    }
+    if (freeze) ucv_set_constant(root, true);
+    return root;
+}
+
+/*
+ * getall():     l1parser.devices proxy, nothing is copied up front
+ * getall(true): the whole profile as a frozen object, built once per
+ *               profile revision and shared by every call on this context
+ */
 static uc_value_t *
 uc_l1_get_all(uc_vm_t *vm, size_t nargs) {
     L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    uc_value_t *materialize = uc_fn_arg(0);
     if (!ctx || !*ctx) err_return(EBADF);
+    if (materialize && ucv_type(materialize) != UC_BOOLEAN) err_return(EINVAL);
 
     return L1_GUARD(({
-        // root object
-        uc_value_t *root = ucv_object_new(vm);
-        
-        const auto& devs = (*ctx)->inner.get_all();
-
-        // every k-v pairs in all dev maps
-        // here k for dev name, v for L1Entry
-        for (const auto& kv : devs) {
-            const std::string& dev_key = kv.first;      // e.g. "MT7981_1_1"
-            const L1Entry& entry = kv.second;
-
-            // current dev props
-            uc_value_t *child_obj = map_to_uc_object(vm, entry.props);
-
-            // root = { dev_key: {dev_props} }
-            ucv_object_add(root, dev_key.c_str(), child_obj);
+        // Hold the snapshot so a background reload cannot free it mid-walk
+        auto snap = (*ctx)->inner.snapshot();
+        uc_value_t *res;
+        if (ucv_boolean_get(materialize)) {
+            if (!(*ctx)->tree || (*ctx)->tree_snap != snap) {
+                ucv_put((*ctx)->tree);
+                (*ctx)->tree = snapshot_to_uc_object(vm, *snap, true);
+                (*ctx)->tree_snap = snap;
+            }
+            res = ucv_get((*ctx)->tree);
+        } else {
+            auto *proxy = new L1DevicesProxy{ std::move(snap) };
+            res = ucv_resource_new(l1_devs_type, proxy);
         }
-        root;
+        res;
+    }));
+}
+
+/* --- Proxy methods --- */
+
+// devs.get(dev): l1parser.device proxy, null for an unknown device
+static uc_value_t *
+uc_l1_devs_get(uc_vm_t *vm, size_t nargs)
+{
+    L1DevicesProxy **devs = reinterpret_cast<L1DevicesProxy **>(uc_fn_this("l1parser.devices"));
+    uc_value_t *dev = uc_fn_arg(0);
+
+    if (!devs || !*devs) err_return(EBADF);
+    if (ucv_type(dev) != UC_STRING) err_return(EINVAL);
+
+    return L1_GUARD(({
+        const L1Snapshot& snap = *(*devs)->snap;
+        std::string_view key(ucv_string_get(dev), ucv_string_length(dev));
+        // Device keys are sorted, the proxy keeps the snapshot's own view
+        size_t lo = 0, hi = snap.dev_count();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (snap.dev_key(mid) < key) lo = mid + 1;
+            else hi = mid;
+        }
+        lo < snap.dev_count() && snap.dev_key(lo) == key
+            ? ucv_resource_new(l1_dev_type, new L1DeviceProxy{ (*devs)->snap, snap.dev_key(lo) })
+            : NULL;
+    }));
+}
+
+// devs.list(): device keys, same as ctx.list() at the time of getall()
+static uc_value_t *
+uc_l1_devs_list(uc_vm_t *vm, size_t nargs)
+{
+    L1DevicesProxy **devs = reinterpret_cast<L1DevicesProxy **>(uc_fn_this("l1parser.devices"));
+
+    if (!devs || !*devs) err_return(EBADF);
+
+    return L1_GUARD(vector_to_uc_array(vm, (*devs)->snap->list_devs()));
+}
+
+// devs.all(): plain object, as getall() used to return
+static uc_value_t *
+uc_l1_devs_all(uc_vm_t *vm, size_t nargs)
+{
+    L1DevicesProxy **devs = reinterpret_cast<L1DevicesProxy **>(uc_fn_this("l1parser.devices"));
+
+    if (!devs || !*devs) err_return(EBADF);
+
+    return L1_GUARD(snapshot_to_uc_object(vm, *(*devs)->snap, false));
+}
+
+// dev.get(key): property value or null
+static uc_value_t *
+uc_l1_dev_get(uc_vm_t *vm, size_t nargs)
+{
+    L1DeviceProxy **dev = reinterpret_cast<L1DeviceProxy **>(uc_fn_this("l1parser.device"));
+    uc_value_t *key = uc_fn_arg(0);
+
+    if (!dev || !*dev) err_return(EBADF);
+    if (ucv_type(key) != UC_STRING) err_return(EINVAL);
+
+    return L1_GUARD(({
+        auto v = (*dev)->snap->prop_view((*dev)->dev, std::string_view(ucv_string_get(key), ucv_string_length(key)));
+        v ? ucv_string_new_length(v->data(), v->size()) : NULL;
+    }));
+}
+
+// dev.all(): { key: value } of this device only
+static uc_value_t *
+uc_l1_dev_all(uc_vm_t *vm, size_t nargs)
+{
+    L1DeviceProxy **dev = reinterpret_cast<L1DeviceProxy **>(uc_fn_this("l1parser.device"));
+
+    if (!dev || !*dev) err_return(EBADF);
+
+    return L1_GUARD(({
+        const auto& all = (*dev)->snap->get_all();
+        auto it = all.find((*dev)->dev);
+        it != all.end() ? entry_to_uc_object(vm, it->second) : NULL;
     }));
 }
 
@@ -141,6 +280,23 @@ uc_l1_if2dat(uc_vm_t *vm, size_t nargs)
     }));
 }
 
+/* ctx.dat_get(ifname, key): key from the per-band .dat of ifname */
+static uc_value_t *
+uc_l1_dat_get(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    uc_value_t *ifname = uc_fn_arg(0);
+    uc_value_t *key = uc_fn_arg(1);
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    if (ucv_type(ifname) != UC_STRING || ucv_type(key) != UC_STRING) err_return(EINVAL);
+
+    return L1_GUARD(({
+        auto res = (*ctx)->inner.dat_get(ucv_string_get(ifname), ucv_string_get(key));
+        res.has_value() ? ucv_string_new(res.value().c_str()) : NULL;
+    }));
+}
+
 static uc_value_t *
 uc_l1_zone2if(uc_vm_t *vm, size_t nargs)
 {
@@ -155,6 +311,51 @@ uc_l1_zone2if(uc_vm_t *vm, size_t nargs)
     ));
 }
 
+/* --- Helper: answer a relation lookup as a ucode array --- */
+template <typename Relation>
+static uc_value_t *
+relation_to_uc_array(uc_vm_t *vm, size_t nargs, Relation rel)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    uc_value_t *val = uc_fn_arg(0);
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    if (ucv_type(val) != UC_STRING) err_return(EINVAL);
+
+    return L1_GUARD(({
+        auto snap = (*ctx)->inner.snapshot();
+        uc_value_t *arr = ucv_array_new(vm);
+        for (const auto &name : rel(*snap, std::string_view(ucv_string_get(val)))) {
+            ucv_array_push(arr, ucv_string_new_length(name.data(), name.size()));
+        }
+        arr;
+    }));
+}
+
+static uc_value_t *
+uc_l1_zone2devs(uc_vm_t *vm, size_t nargs)
+{
+    return relation_to_uc_array(vm, nargs, [](const L1Snapshot &s, std::string_view k) -> const auto & { return s.zone2devs(k); });
+}
+
+static uc_value_t *
+uc_l1_zone2ifs(uc_vm_t *vm, size_t nargs)
+{
+    return relation_to_uc_array(vm, nargs, [](const L1Snapshot &s, std::string_view k) -> const auto & { return s.zone2ifs(k); });
+}
+
+static uc_value_t *
+uc_l1_dat2ifs(uc_vm_t *vm, size_t nargs)
+{
+    return relation_to_uc_array(vm, nargs, [](const L1Snapshot &s, std::string_view k) -> const auto & { return s.dat2ifs(k); });
+}
+
+static uc_value_t *
+uc_l1_dev2ifs(uc_vm_t *vm, size_t nargs)
+{
+    return relation_to_uc_array(vm, nargs, [](const L1Snapshot &s, std::string_view k) -> const auto & { return s.dev2ifs(k); });
+}
+
 static uc_value_t *
 uc_l1_if2dbdcidx(uc_vm_t *vm, size_t nargs)
 {
@@ -185,6 +386,254 @@ uc_l1_idx2if(uc_vm_t *vm, size_t nargs)
     }));
 }
 
+static uc_value_t *
+uc_l1_idxtable(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    if (!ctx || !*ctx) err_return(EBADF);
+
+    return L1_GUARD(vector_to_uc_array(
+        vm, (*ctx)->inner.idx_table()
+    ));
+}
+
+static uc_value_t *
+uc_l1_if2idx(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    uc_value_t *val = uc_fn_arg(0);
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    if (ucv_type(val) != UC_STRING) err_return(EINVAL);
+
+    return L1_GUARD(({
+        auto res = (*ctx)->inner.if2idx(ucv_string_get(val));
+        res.has_value() ? ucv_int64_new((int64_t)res.value()) : NULL;
+    }));
+}
+
+static uc_value_t *
+uc_l1_watch(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    if (!(*ctx)->inner.watch()) err_return(errno ? errno : ENOENT);
+
+    return ucv_boolean_new(true);
+}
+
+/* ctx.set(dev, key, value) / ctx.dat_set(ifname, key, value): stage an
+ * edit, written back by ctx.commit() */
+static uc_value_t *
+uc_l1_set_common(uc_vm_t *vm, size_t nargs, bool dat)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    uc_value_t *name = uc_fn_arg(0);
+    uc_value_t *key = uc_fn_arg(1);
+    uc_value_t *val = uc_fn_arg(2);
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    if (ucv_type(name) != UC_STRING || ucv_type(key) != UC_STRING || ucv_type(val) != UC_STRING)
+        err_return(EINVAL);
+
+    bool ok;
+    try {
+        L1Parser &p = (*ctx)->inner;
+        ok = dat ? p.set_dat(ucv_string_get(name), ucv_string_get(key), ucv_string_get(val))
+                 : p.set_prop(ucv_string_get(name), ucv_string_get(key), ucv_string_get(val));
+    } catch (...) {
+        ok = false;
+    }
+    if (!ok) err_return(EINVAL);
+
+    return ucv_boolean_new(true);
+}
+
+static uc_value_t *
+uc_l1_set(uc_vm_t *vm, size_t nargs)
+{
+    return uc_l1_set_common(vm, nargs, false);
+}
+
+static uc_value_t *
+uc_l1_dat_set(uc_vm_t *vm, size_t nargs)
+{
+    return uc_l1_set_common(vm, nargs, true);
+}
+
+/* ctx.commit(): one atomic rewrite per touched file */
+static uc_value_t *
+uc_l1_commit(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+
+    if (!ctx || !*ctx) err_return(EBADF);
+
+    bool ok;
+    try {
+        ok = (*ctx)->inner.commit();
+    } catch (...) {
+        ok = false;
+    }
+    if (!ok) err_return(errno ? errno : EIO);
+
+    return ucv_boolean_new(true);
+}
+
+static uc_value_t *
+uc_l1_discard(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    (*ctx)->inner.discard();
+
+    return ucv_boolean_new(true);
+}
+
+/* ctx.reload(): re-read the profile now and return what changed,
+ * { devices: { added, removed, modified: { dev: [keys] } },
+ *   interfaces: { added, removed, modified } } */
+static uc_value_t *
+uc_l1_reload(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+
+    if (!ctx || !*ctx) err_return(EBADF);
+
+    L1Diff diff;
+    bool ok;
+    try {
+        ok = (*ctx)->inner.reload(&diff);
+    } catch (...) {
+        ok = false;
+    }
+    if (!ok) err_return(errno ? errno : ENOENT);
+
+    return L1_GUARD(({
+        uc_value_t *devs = ucv_object_new(vm);
+        ucv_object_add(devs, "added", vector_to_uc_array(vm, diff.devs_added));
+        ucv_object_add(devs, "removed", vector_to_uc_array(vm, diff.devs_removed));
+        uc_value_t *modified = ucv_object_new(vm);
+        for (const auto &[dev, keys] : diff.devs_modified) {
+            ucv_object_add(modified, dev.c_str(), vector_to_uc_array(vm, keys));
+        }
+        ucv_object_add(devs, "modified", modified);
+
+        uc_value_t *ifs = ucv_object_new(vm);
+        ucv_object_add(ifs, "added", vector_to_uc_array(vm, diff.ifs_added));
+        ucv_object_add(ifs, "removed", vector_to_uc_array(vm, diff.ifs_removed));
+        ucv_object_add(ifs, "modified", vector_to_uc_array(vm, diff.ifs_modified));
+
+        uc_value_t *obj = ucv_object_new(vm);
+        ucv_object_add(obj, "devices", devs);
+        ucv_object_add(obj, "interfaces", ifs);
+        obj;
+    }));
+}
+
+/* ctx.stats(): the fields of l1_stats(), latencies keyed by bucket bound */
+static uc_value_t *
+uc_l1_stats(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+
+    if (!ctx || !*ctx) err_return(EBADF);
+
+    return L1_GUARD(({
+        L1Stats stats = (*ctx)->inner.stats();
+        uc_value_t *obj = ucv_object_new(vm);
+        ucv_object_add(obj, "enabled", ucv_boolean_new(stats.enabled));
+        ucv_object_add(obj, "loads", ucv_int64_new((int64_t)stats.loads));
+        ucv_object_add(obj, "load_failures", ucv_int64_new((int64_t)stats.load_failures));
+
+        const L1LoadStats &l = stats.last_load;
+        uc_value_t *load = ucv_object_new(vm);
+        ucv_object_add(load, "from_image", ucv_boolean_new(l.from_image));
+        ucv_object_add(load, "bytes", ucv_int64_new((int64_t)l.bytes));
+        ucv_object_add(load, "blocks", ucv_int64_new((int64_t)l.blocks));
+        ucv_object_add(load, "blocks_reused", ucv_int64_new((int64_t)l.blocks_reused));
+        ucv_object_add(load, "entries", ucv_int64_new((int64_t)l.entries));
+        ucv_object_add(load, "main_ifs", ucv_int64_new((int64_t)l.main_ifs));
+        ucv_object_add(load, "if_rules", ucv_int64_new((int64_t)l.if_rules));
+        uc_value_t *phases = ucv_object_new(vm);
+        for (size_t i = 0; i < L1_LOAD_PHASE_COUNT; ++i) {
+            ucv_object_add(phases, l1_load_phase_name((L1LoadPhase)i), ucv_int64_new((int64_t)l.phase_ns[i]));
+        }
+        ucv_object_add(load, "phase_ns", phases);
+        ucv_object_add(obj, "last_load", load);
+
+        uc_value_t *apis = ucv_object_new(vm);
+        for (size_t i = 0; i < L1_API_COUNT; ++i) {
+            const L1ApiStats &a = stats.api[i];
+            if (a.calls == 0) continue;
+            uc_value_t *api = ucv_object_new(vm);
+            ucv_object_add(api, "calls", ucv_int64_new((int64_t)a.calls));
+            ucv_object_add(api, "total_ns", ucv_int64_new((int64_t)a.total_ns));
+            uc_value_t *hist = ucv_object_new(vm);
+            for (size_t b = 0; b < L1_STATS_BUCKETS; ++b) {
+                if (a.hist[b] == 0) continue;
+                std::string bound = b + 1 < L1_STATS_BUCKETS
+                    ? "lt_" + std::to_string(l1_stats_bucket_limit_ns(b)) + "ns" : "inf";
+                ucv_object_add(hist, bound.c_str(), ucv_int64_new((int64_t)a.hist[b]));
+            }
+            ucv_object_add(api, "hist", hist);
+            ucv_object_add(apis, l1_api_name((L1Api)i), api);
+        }
+        ucv_object_add(obj, "api", apis);
+        obj;
+    }));
+}
+
+/* ctx.memory(): bytes per structure, the fields of l1_memory_usage() */
+static uc_value_t *
+uc_l1_memory(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+
+    if (!ctx || !*ctx) err_return(EBADF);
+
+    return L1_GUARD(({
+        L1MemUsage m = (*ctx)->inner.memory_usage();
+        uc_value_t *obj = ucv_object_new(vm);
+        ucv_object_add(obj, "compact", ucv_boolean_new(m.compact));
+        ucv_object_add(obj, "strings", ucv_int64_new((int64_t)m.strings));
+        ucv_object_add(obj, "blocks", ucv_int64_new((int64_t)m.blocks));
+        ucv_object_add(obj, "dev_map", ucv_int64_new((int64_t)m.dev_map));
+        ucv_object_add(obj, "dev_keys", ucv_int64_new((int64_t)m.dev_keys));
+        ucv_object_add(obj, "index", ucv_int64_new((int64_t)m.index));
+        ucv_object_add(obj, "image", ucv_int64_new((int64_t)m.image));
+        ucv_object_add(obj, "if_map", ucv_int64_new((int64_t)m.if_map));
+        ucv_object_add(obj, "relations", ucv_int64_new((int64_t)m.relations));
+        ucv_object_add(obj, "total", ucv_int64_new((int64_t)m.total()));
+        ucv_object_add(obj, "arena", ucv_int64_new((int64_t)m.arena));
+        ucv_object_add(obj, "arena_chunks", ucv_int64_new((int64_t)m.arena_chunks));
+        obj;
+    }));
+}
+
+/* ctx.compact([on]): keep the profile as a packed in-memory image */
+static uc_value_t *
+uc_l1_compact(uc_vm_t *vm, size_t nargs)
+{
+    L1Context **ctx = reinterpret_cast<L1Context **>(uc_fn_this("l1parser.context"));
+    uc_value_t *on = uc_fn_arg(0);
+
+    if (!ctx || !*ctx) err_return(EBADF);
+    if (on && ucv_type(on) != UC_BOOLEAN) err_return(EINVAL);
+
+    bool ok;
+    try {
+        ok = (*ctx)->inner.set_compact(on ? ucv_boolean_get(on) : true);
+    } catch (...) {
+        ok = false;
+    }
+    if (!ok) err_return(errno ? errno : ENOENT);
+
+    return ucv_boolean_new(true);
+}
+
 static uc_value_t *
 uc_l1_close(uc_vm_t *vm, size_t nargs)
 {
@@ -236,12 +685,39 @@ static const uc_function_list_t ctx_fns[] = {
     { "getall",        uc_l1_get_all },
     { "if2zone",        uc_l1_if2zone },
     { "if2dat",         uc_l1_if2dat },
+    { "dat_get",        uc_l1_dat_get },
     { "zone2if",        uc_l1_zone2if },
+    { "zone2devs",      uc_l1_zone2devs },
+    { "zone2ifs",       uc_l1_zone2ifs },
+    { "dat2ifs",        uc_l1_dat2ifs },
+    { "dev2ifs",        uc_l1_dev2ifs },
     { "if2dbdcidx",     uc_l1_if2dbdcidx },
     { "idx2if",         uc_l1_idx2if },
+    { "idxtable",       uc_l1_idxtable },
+    { "if2idx",         uc_l1_if2idx },
+    { "watch",          uc_l1_watch },
+    { "reload",         uc_l1_reload },
+    { "set",            uc_l1_set },
+    { "dat_set",        uc_l1_dat_set },
+    { "commit",         uc_l1_commit },
+    { "discard",        uc_l1_discard },
+    { "stats",          uc_l1_stats },
+    { "memory",         uc_l1_memory },
+    { "compact",        uc_l1_compact },
     { "close",          uc_l1_close },
 };
 
+static const uc_function_list_t devs_fns[] = {
+    { "get",            uc_l1_devs_get },
+    { "list",           uc_l1_devs_list },
+    { "all",            uc_l1_devs_all },
+};
+
+static const uc_function_list_t dev_fns[] = {
+    { "get",            uc_l1_dev_get },
+    { "all",            uc_l1_dev_all },
+};
+
 static const uc_function_list_t global_fns[] = {
     { "open",           uc_l1_open },
     { "error",          uc_l1_error },
@@ -252,5 +728,7 @@ extern "C" {
     {
         uc_function_list_register(scope, global_fns);
         l1_ctx_type = uc_type_declare(vm, "l1parser.context", ctx_fns, close_ctx);
+        l1_devs_type = uc_type_declare(vm, "l1parser.devices", devs_fns, close_devs);
+        l1_dev_type = uc_type_declare(vm, "l1parser.device", dev_fns, close_dev);
     }
 } // extern "C"
\ No newline at end of file
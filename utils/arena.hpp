@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace utils {
+
+/**
+ * @brief Caller-owned memory lent to one Arena at a time.
+ *
+ * Shared between whoever hands the buffer out and the arenas using it; an
+ * arena that finds it taken falls back to the heap.
+ */
+class ArenaBuffer {
+public:
+    ArenaBuffer(void* data, size_t size) : data_(data), size_(size) {}
+
+private:
+    friend class Arena;
+
+    void* data_;
+    size_t size_;
+    std::atomic<bool> busy_{ false };
+};
+
+/**
+ * @brief Monotonic arena: allocations bump a pointer through a few large
+ * chunks, deallocation is a no-op and everything is returned at once when the
+ * arena is destroyed.
+ *
+ * Nothing is reserved until the first allocation, so the first chunk can be
+ * sized (reserve()) once the amount of data is known, and a lent caller
+ * buffer (lend()) is only claimed by an arena that actually uses memory.
+ * Not thread-safe, like std::pmr::monotonic_buffer_resource.
+ */
+class Arena : public std::pmr::memory_resource {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() {
+        res_.reset();
+        if (buf_) buf_->busy_.store(false, std::memory_order_release);
+    }
+
+    // Size of the first heap chunk; ignored once anything was allocated
+    void reserve(size_t bytes) {
+        if (!res_) initial_ = bytes;
+    }
+    // Start in buf instead of the heap, if no other arena holds it by the
+    // first allocation
+    void lend(std::shared_ptr<ArenaBuffer> buf) {
+        if (!res_) lent_ = std::move(buf);
+    }
+
+    // Bytes reserved: the caller buffer if one was used, plus heap chunks
+    size_t capacity() const {
+        return buf_size_.load(std::memory_order_relaxed) + upstream_.bytes.load(std::memory_order_relaxed);
+    }
+    // Heap allocations made, one per chunk
+    size_t chunks() const { return upstream_.chunks.load(std::memory_order_relaxed); }
+
+private:
+    // Counts the chunks taken from the heap
+    struct Upstream : std::pmr::memory_resource {
+        std::atomic<size_t> bytes{ 0 }, chunks{ 0 };
+
+        void* do_allocate(size_t n, size_t align) override {
+            void* p = std::pmr::new_delete_resource()->allocate(n, align);
+            bytes.fetch_add(n, std::memory_order_relaxed);
+            chunks.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+        void do_deallocate(void* p, size_t n, size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, n, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    void* do_allocate(size_t n, size_t align) override {
+        if (!res_) {
+            if (lent_ && !lent_->busy_.exchange(true, std::memory_order_acquire)) buf_ = std::move(lent_);
+            lent_.reset();
+            if (buf_) {
+                res_.emplace(buf_->data_, buf_->size_, &upstream_);
+                buf_size_.store(buf_->size_, std::memory_order_relaxed);
+            } else if (initial_) res_.emplace(initial_, &upstream_);
+            else res_.emplace(&upstream_);
+        }
+        return res_->allocate(n, align);
+    }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    Upstream upstream_;
+    std::optional<std::pmr::monotonic_buffer_resource> res_;
+    std::shared_ptr<ArenaBuffer> lent_;
+    std::shared_ptr<ArenaBuffer> buf_;     // claimed from lent_
+    std::atomic<size_t> buf_size_{ 0 };     // for capacity() while allocating
+    size_t initial_ = 0;
+};
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cerrno>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace utils {
+
+/**
+ * @brief Read-only view of a file's contents.
+ *
+ * Regular files are mmap'ed; anything else (pipes, procfs, empty files) is
+ * read into a heap buffer instead. The view stays valid until the FileView
+ * is destroyed, even if the file is replaced on disk meanwhile.
+ */
+class FileView {
+public:
+    FileView() = default;
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    ~FileView() {
+        if (map_) munmap(map_, size_);
+    }
+
+    // st is the caller's fstat() result for fd
+    bool open(int fd, const struct stat& st) {
+        if (S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map_ = p;
+                size_ = (size_t)st.st_size;
+                return true;
+            }
+        }
+
+        char tmp[4096];
+        for (;;) {
+            ssize_t n = ::read(fd, tmp, sizeof(tmp));
+            if (n == 0) break;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            buf_.append(tmp, (size_t)n);
+        }
+        return true;
+    }
+
+    std::string_view data() const {
+        if (map_) return std::string_view(static_cast<const char*>(map_), size_);
+        return buf_;
+    }
+
+private:
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::string buf_;
+};
+
+}
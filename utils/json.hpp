@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/**
+ * @brief Writes s as a JSON string literal.
+ *
+ * put(std::string_view) receives the output piece by piece: runs of s that
+ * need no escaping go out whole, so a buffered writer copies them straight
+ * from s. Quotes and backslashes are escaped, other control characters
+ * become \u00XX; everything else, UTF-8 included, passes through.
+ */
+template <typename Put>
+inline void put_json_string(std::string_view s, Put put) {
+    static const char hex[] = "0123456789abcdef";
+    put("\"");
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        put(s.substr(start, i - start));
+        if (c == '"' || c == '\\') {
+            const char esc[] = { '\\', (char)c };
+            put(std::string_view(esc, sizeof(esc)));
+        } else {
+            const char esc[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            put(std::string_view(esc, sizeof(esc)));
+        }
+        start = i + 1;
+    }
+    put(s.substr(start));
+    put("\"");
+}
+
+// put_json_string() appending to out
+inline void append_json_string(std::string& out, std::string_view s) {
+    put_json_string(s, [&](std::string_view part) { out += part; });
+}
+
+}
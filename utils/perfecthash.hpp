@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+// Per-bucket displacement of a PerfectHash, also stored as-is in images
+struct PerfectHashDisp {
+    uint32_t d0;
+    uint32_t d1;
+};
+
+inline uint64_t phash_mix(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    return x;
+}
+
+// Seeded 64-bit string hash, one multiply per 8 bytes and one final mix.
+// Words are assembled byte by byte so images hash the same on any host.
+inline uint64_t phash(std::string_view s, uint64_t seed) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s.data());
+    size_t n = s.size();
+    uint64_t h = seed ^ (n * 0x9e3779b97f4a7c15ULL);
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t w = 0;
+        for (int i = 7; i >= 0; --i) w = (w << 8) | p[i];
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 29;
+    }
+    uint64_t w = 0;
+    for (size_t i = n; i > 0; --i) w = (w << 8) | p[i - 1];
+    return phash_mix(h ^ w);
+}
+
+// Map a 32-bit value onto [0, n) without a division
+inline uint32_t phash_range(uint32_t x, uint32_t n) {
+    return (uint32_t)(((uint64_t)x * n) >> 32);
+}
+
+/**
+ * @brief Minimal perfect hash over a fixed key set (CHD, "hash and displace").
+ *
+ * Keys are hashed into n/2 buckets; each bucket gets a displacement pair
+ * (d0, d1) that moves all of its keys onto free slots, so the n keys map to
+ * exactly the slots 0..n-1. A lookup is one string hash and one table read.
+ * Keys outside the build set also land on some slot, so callers confirm a
+ * hit with a single comparison against the key stored at that slot. The
+ * table comes from the given memory resource.
+ */
+class PerfectHash {
+public:
+    explicit PerfectHash(std::pmr::memory_resource* mr = std::pmr::get_default_resource()) : disp_(mr) {}
+
+    // Keys must be distinct. Returns false if no seed worked (or on duplicates).
+    template <typename Alloc>
+    bool build(const std::vector<std::string_view, Alloc>& keys) {
+        n_ = (uint32_t)keys.size();
+        disp_.clear();
+        if (n_ == 0) return true;
+
+        uint32_t n_buckets = (n_ + 1) / 2;
+        // Scratch tables of every attempt from one block, ~24 bytes per key each
+        std::pmr::monotonic_buffer_resource tmp(n_ * 48 + 256);
+        for (uint64_t attempt = 0; attempt < MAX_SEEDS; ++attempt) {
+            seed_ = phash_mix(attempt + 0x6c317061726e6b31ULL);
+            disp_.assign(n_buckets, PerfectHashDisp{ 0, 0 });
+            if (try_build(keys.data(), &tmp)) return true;
+        }
+        disp_.clear();
+        n_ = 0;
+        return false;
+    }
+
+    uint32_t size() const { return n_; }
+    uint64_t seed() const { return seed_; }
+    const std::pmr::vector<PerfectHashDisp>& displacements() const { return disp_; }
+
+    // Slot of key in [0, size()), size() must not be 0
+    uint32_t slot(std::string_view key) const {
+        return slot_of(key, seed_, disp_.data(), (uint32_t)disp_.size(), n_);
+    }
+
+    // Same lookup over a table stored elsewhere (e.g. a mapped image)
+    static uint32_t slot_of(std::string_view key, uint64_t seed, const PerfectHashDisp* disp,
+                            uint32_t n_buckets, uint32_t n) {
+        uint64_t h = phash(key, seed);
+        const PerfectHashDisp& d = disp[phash_range((uint32_t)(h >> 32), n_buckets)];
+        return position(h, d.d0, d.d1, n);
+    }
+
+private:
+    static const uint64_t MAX_SEEDS = 32;
+    static const uint32_t MAX_D0 = 1024;
+
+    // d1 < n, so the final reduction is a conditional subtract
+    static uint32_t position(uint64_t h, uint32_t d0, uint32_t d1, uint32_t n) {
+        uint32_t f1 = (uint32_t)h;
+        uint32_t f2 = (uint32_t)((h * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+        uint32_t p = phash_range(f1 + d0 * f2, n) + d1;
+        return p >= n ? p - n : p;
+    }
+
+    bool try_build(const std::string_view* keys, std::pmr::memory_resource* tmp) {
+        uint32_t n_buckets = (uint32_t)disp_.size();
+        std::pmr::vector<uint64_t> hashes(n_, tmp);
+        std::pmr::vector<uint32_t> bucket_of(n_, tmp);
+        std::pmr::vector<uint32_t> start(n_buckets + 1, 0, tmp);
+        for (uint32_t i = 0; i < n_; ++i) {
+            hashes[i] = phash(keys[i], seed_);
+            bucket_of[i] = phash_range((uint32_t)(hashes[i] >> 32), n_buckets);
+            start[bucket_of[i] + 1]++;
+        }
+        // Flat bucket lists: members of bucket b are keys_by_bucket[start[b] .. start[b + 1])
+        for (uint32_t b = 0; b < n_buckets; ++b) start[b + 1] += start[b];
+        std::pmr::vector<uint32_t> keys_by_bucket(n_, tmp);
+        std::pmr::vector<uint32_t> fill(start.begin(), start.end() - 1, tmp);
+        for (uint32_t i = 0; i < n_; ++i) keys_by_bucket[fill[bucket_of[i]]++] = i;
+
+        // Place crowded buckets first, while most slots are still free
+        std::pmr::vector<uint32_t> order(n_buckets, tmp);
+        for (uint32_t b = 0; b < n_buckets; ++b) order[b] = b;
+        auto bucket_size = [&](uint32_t b) { return start[b + 1] - start[b]; };
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return bucket_size(a) > bucket_size(b);
+        });
+
+        std::pmr::vector<bool> taken(n_, false, tmp);
+        std::pmr::vector<uint32_t> pos(tmp);
+        uint32_t next_free = 0;
+        for (uint32_t b : order) {
+            const uint32_t* members = keys_by_bucket.data() + start[b];
+            uint32_t size = bucket_size(b);
+            if (size == 0) break;
+
+            // A single key fits any free slot: d1 rotates it straight there
+            if (size == 1) {
+                while (taken[next_free]) next_free++;
+                uint32_t p0 = position(hashes[members[0]], 0, 0, n_);
+                disp_[b] = { 0, next_free >= p0 ? next_free - p0 : next_free + n_ - p0 };
+                taken[next_free] = true;
+                continue;
+            }
+
+            bool placed = false;
+            for (uint32_t d0 = 0; d0 < MAX_D0 && !placed; ++d0) {
+                for (uint32_t d1 = 0; d1 < n_ && !placed; ++d1) {
+                    pos.clear();
+                    bool ok = true;
+                    for (uint32_t m = 0; m < size; ++m) {
+                        uint32_t p = position(hashes[members[m]], d0, d1, n_);
+                        if (taken[p] || std::find(pos.begin(), pos.end(), p) != pos.end()) {
+                            ok = false;
+                            break;
+                        }
+                        pos.push_back(p);
+                    }
+                    if (!ok) continue;
+                    for (uint32_t p : pos) taken[p] = true;
+                    disp_[b] = { d0, d1 };
+                    placed = true;
+                }
+            }
+            // Identical hashes (or keys) in one bucket never separate, reseed
+            if (!placed) return false;
+        }
+        return true;
+    }
+
+    uint64_t seed_ = 0;
+    uint32_t n_ = 0;
+    std::pmr::vector<PerfectHashDisp> disp_;
+};
+
+}
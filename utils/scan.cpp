@@ -0,0 +1,164 @@
+#include "scan.hpp"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define L1_SCAN_X86 1
+#endif
+
+namespace utils {
+
+static const size_t npos = std::string_view::npos;
+
+struct ScanOps {
+    ScanImpl impl;
+    size_t (*find1)(const char* p, size_t n, char a);
+    size_t (*find2)(const char* p, size_t n, char a, char b);
+};
+
+/* --- Scalar --- */
+
+static size_t find1_scalar(const char* p, size_t n, char a) {
+    // libc memchr is already word-at-a-time on every target we ship
+    const void* hit = memchr(p, a, n);
+    return hit ? (size_t)(static_cast<const char*>(hit) - p) : npos;
+}
+
+static size_t find2_scalar(const char* p, size_t n, char a, char b) {
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] == a || p[i] == b) return i;
+    }
+    return npos;
+}
+
+static const ScanOps scalar_ops = { ScanImpl::Scalar, find1_scalar, find2_scalar };
+
+#ifdef L1_SCAN_X86
+
+/* --- SSE2 (16 bytes per step) --- */
+
+__attribute__((target("sse2")))
+static size_t find1_sse2(const char* p, size_t n, char a) {
+    const __m128i va = _mm_set1_epi8(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int m = _mm_movemask_epi8(_mm_cmpeq_epi8(v, va));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    size_t r = find1_scalar(p + i, n - i, a);
+    return r == npos ? npos : i + r;
+}
+
+__attribute__((target("sse2")))
+static size_t find2_sse2(const char* p, size_t n, char a, char b) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    size_t r = find2_scalar(p + i, n - i, a, b);
+    return r == npos ? npos : i + r;
+}
+
+/* --- AVX2 (32 bytes per step) --- */
+
+__attribute__((target("avx2")))
+static size_t find1_avx2(const char* p, size_t n, char a) {
+    const __m256i va = _mm256_set1_epi8(a);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, va));
+        if (m) return i + (size_t)__builtin_ctz(m);
+    }
+    size_t r = find1_sse2(p + i, n - i, a);
+    return r == npos ? npos : i + r;
+}
+
+__attribute__((target("avx2")))
+static size_t find2_avx2(const char* p, size_t n, char a, char b) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+        if (m) return i + (size_t)__builtin_ctz(m);
+    }
+    size_t r = find2_sse2(p + i, n - i, a, b);
+    return r == npos ? npos : i + r;
+}
+
+static const ScanOps sse2_ops = { ScanImpl::SSE2, find1_sse2, find2_sse2 };
+static const ScanOps avx2_ops = { ScanImpl::AVX2, find1_avx2, find2_avx2 };
+
+#endif // L1_SCAN_X86
+
+/* --- Dispatch --- */
+
+static const ScanOps* ops_for(ScanImpl impl) {
+#ifdef L1_SCAN_X86
+    __builtin_cpu_init();
+    if (impl == ScanImpl::AVX2) return __builtin_cpu_supports("avx2") ? &avx2_ops : nullptr;
+    if (impl == ScanImpl::SSE2) return __builtin_cpu_supports("sse2") ? &sse2_ops : nullptr;
+#endif
+    if (impl == ScanImpl::Scalar) return &scalar_ops;
+    return nullptr;
+}
+
+static const ScanOps* select_ops() {
+    for (ScanImpl impl : { ScanImpl::AVX2, ScanImpl::SSE2 }) {
+        if (const ScanOps* ops = ops_for(impl)) return ops;
+    }
+    return &scalar_ops;
+}
+
+static std::atomic<const ScanOps*> current_ops{ nullptr };
+
+static const ScanOps* ops() {
+    const ScanOps* o = current_ops.load(std::memory_order_relaxed);
+    if (!o) {
+        o = select_ops();
+        current_ops.store(o, std::memory_order_relaxed);
+    }
+    return o;
+}
+
+size_t scan_for(std::string_view s, size_t pos, char a) {
+    if (pos >= s.size()) return npos;
+    size_t r = ops()->find1(s.data() + pos, s.size() - pos, a);
+    return r == npos ? npos : pos + r;
+}
+
+size_t scan_for(std::string_view s, size_t pos, char a, char b) {
+    if (pos >= s.size()) return npos;
+    size_t r = ops()->find2(s.data() + pos, s.size() - pos, a, b);
+    return r == npos ? npos : pos + r;
+}
+
+ScanImpl scan_impl() {
+    return ops()->impl;
+}
+
+const char* scan_impl_name(ScanImpl impl) {
+    switch (impl) {
+    case ScanImpl::AVX2: return "avx2";
+    case ScanImpl::SSE2: return "sse2";
+    default:             return "scalar";
+    }
+}
+
+bool set_scan_impl(ScanImpl impl) {
+    const ScanOps* o = ops_for(impl);
+    if (!o) return false;
+    current_ops.store(o, std::memory_order_relaxed);
+    return true;
+}
+
+}
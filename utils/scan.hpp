@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace utils {
+
+/**
+ * Vectorized byte search used by the profile tokenizer.
+ *
+ * The implementation is picked once at runtime: AVX2 when the CPU supports
+ * it, SSE2 on other x86 machines and a scalar loop everywhere else.
+ * Both functions return the position of the first matching byte at or after
+ * pos, or std::string_view::npos.
+ */
+size_t scan_for(std::string_view s, size_t pos, char a);
+size_t scan_for(std::string_view s, size_t pos, char a, char b);
+
+enum class ScanImpl { Scalar, SSE2, AVX2 };
+
+ScanImpl scan_impl();
+const char* scan_impl_name(ScanImpl impl);
+// Force an implementation (benchmarks). Returns false if the CPU lacks it.
+bool set_scan_impl(ScanImpl impl);
+
+}
@@ -1,48 +1,84 @@
 #pragma once
-#include <string>
+#include <string_view>
 #include <vector>
-#include <sstream>
-#include <algorithm>
+#include "scan.hpp"
 
 namespace utils {
 
 // Remove leading and trailing whitespace characters (\t, \n, \r, space)
-inline std::string trim(const std::string& str) {
+inline std::string_view trim(std::string_view str) {
     const auto strBegin = str.find_first_not_of(" \t\n\r");
-    if (strBegin == std::string::npos) return "";
+    if (strBegin == std::string_view::npos) return std::string_view();
     const auto strEnd = str.find_last_not_of(" \t\n\r");
     return str.substr(strBegin, strEnd - strBegin + 1);
 }
 
+/**
+ * @brief Tokenizer for "key=value" files (l1profile.dat and the per-band .dat
+ * files it references).
+ *
+ * Calls f(key, value) for every line holding a '=', both trimmed views into
+ * buf. With inline_comments, '#' starts a comment anywhere on a line;
+ * without, only a line starting with '#' is a comment, so values such as
+ * passphrases may contain one.
+ */
+template <typename Func>
+inline void for_each_kv_line(std::string_view buf, bool inline_comments, Func f) {
+    size_t pos = 0;
+    while (pos < buf.size()) {
+        // One vector scan finds either the end of the line or a comment start
+        size_t stop = inline_comments ? scan_for(buf, pos, '\n', '#') : scan_for(buf, pos, '\n');
+        if (stop == std::string_view::npos) stop = buf.size();
+        size_t nl = stop;
+        if (stop < buf.size() && buf[stop] == '#') {
+            nl = scan_for(buf, stop, '\n');
+            if (nl == std::string_view::npos) nl = buf.size();
+        }
+
+        // Handle comments: drop text after '#' and trim whitespace
+        std::string_view text = trim(buf.substr(pos, stop - pos));
+        pos = nl + 1;
+        if (text.empty() || text[0] == '#') continue;
+
+        size_t eq_pos = scan_for(text, 0, '=');
+        if (eq_pos == std::string_view::npos) continue;
+
+        f(trim(text.substr(0, eq_pos)), trim(text.substr(eq_pos + 1)));
+    }
+}
+
 /**
  * @brief split function designed to filter profile values.
- * @param s Input string.
+ * @param s Input string. Tokens are trimmed views into it.
  * @param delimiter The character to split by.
- * @param keep_empty 
- *      true: Preserves empty elements. 
+ * @param keep_empty
+ *      true: Preserves empty elements.
  *            Used for property alignment (e.g., "val1;;val3" -> ["val1", "", "val3"]).
+ *            A trailing delimiter yields a final empty slot ("a;b;" -> ["a", "b", ""]).
  *      false: Filters out empty elements.
  *            Used for main_ifname parsing where gaps don't matter.
+ * @param f Called with each token in order; nothing is allocated.
  */
-inline std::vector<std::string> split(const std::string& s, char delimiter, bool keep_empty) {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(s);
-    
-    // Use getline to process the stream
-    while (std::getline(tokenStream, token, delimiter)) {
-        std::string trimmed = trim(token);
+template <typename Func>
+inline void for_each_split(std::string_view s, char delimiter, bool keep_empty, Func f) {
+    if (s.empty()) return;
+
+    size_t pos = 0;
+    for (;;) {
+        size_t end = scan_for(s, pos, delimiter);
+        std::string_view trimmed = trim(s.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos));
         if (keep_empty || !trimmed.empty()) {
-            tokens.push_back(trimmed);
+            f(trimmed);
         }
+        if (end == std::string_view::npos) break;
+        pos = end + 1;
     }
+}
 
-    // Special case: If keep_empty is true and the string ends with the delimiter (e.g., "a;b;")
-    // std::getline ignores the final empty slot, so we manually add it.
-    if (keep_empty && !s.empty() && s.back() == delimiter) {
-        tokens.push_back("");
-    }
-
+// for_each_split() collected into a vector
+inline std::vector<std::string_view> split(std::string_view s, char delimiter, bool keep_empty) {
+    std::vector<std::string_view> tokens;
+    for_each_split(s, delimiter, keep_empty, [&](std::string_view t) { tokens.push_back(t); });
     return tokens;
 }
 
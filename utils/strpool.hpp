@@ -0,0 +1,98 @@
+#pragma once
+#include <cstring>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief Interning pool: every distinct string is stored exactly once.
+ *
+ * Strings are copied into fixed-size chunks that are never moved or freed
+ * before the pool itself, so returned views stay valid for the pool's
+ * lifetime. Each stored string is followed by a NUL byte, which lets callers
+ * hand view.data() to C APIs directly. Chunks and the index come from the
+ * given memory resource, the default one (the heap) unless told otherwise.
+ */
+class StringPool {
+public:
+    explicit StringPool(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : mr_(mr), chunks_(mr), index_(std::in_place, mr) {}
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    ~StringPool() {
+        for (const Chunk& c : chunks_) mr_->deallocate(c.data, c.size, 1);
+    }
+
+    std::string_view intern(std::string_view s) {
+        auto it = index_->find(s);
+        if (it != index_->end()) return *it;
+
+        std::string_view stored = store(s);
+        index_->insert(stored);
+        return stored;
+    }
+
+    // Keep the lookup index in tmp, which must outlive it, until
+    // release_index(). Only before the first intern().
+    void index_in(std::pmr::memory_resource* tmp) {
+        if (index_->empty()) index_.emplace(tmp);
+    }
+
+    // Drop the lookup index once no more strings are expected. Stored strings
+    // stay valid; later intern() calls still work but no longer deduplicate
+    // against strings added before the release.
+    void release_index() {
+        index_.emplace(mr_);
+    }
+
+    // Bytes reserved for string storage
+    size_t capacity() const { return bytes_; }
+
+private:
+    static const size_t CHUNK_SIZE = 1024;
+
+    std::string_view store(std::string_view s) {
+        size_t need = s.size() + 1;
+        char* dst;
+        if (need > CHUNK_SIZE / 4) {
+            // Oversized strings get their own allocation instead of wasting a chunk
+            dst = allocate(need);
+        } else {
+            if (!cur_ || used_ + need > CHUNK_SIZE) {
+                cur_ = allocate(CHUNK_SIZE);
+                used_ = 0;
+            }
+            dst = cur_ + used_;
+            used_ += need;
+        }
+        if (!s.empty()) memcpy(dst, s.data(), s.size());
+        dst[s.size()] = '\0';
+        return std::string_view(dst, s.size());
+    }
+
+    char* allocate(size_t size) {
+        char* p = static_cast<char*>(mr_->allocate(size, 1));
+        chunks_.push_back({ p, size });
+        bytes_ += size;
+        return p;
+    }
+
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+    using Index = std::pmr::unordered_set<std::string_view>;
+
+    std::pmr::memory_resource* mr_;
+    std::pmr::vector<Chunk> chunks_;
+    char* cur_ = nullptr;       // chunk small strings are appended to
+    size_t used_ = 0;
+    size_t bytes_ = 0;
+    std::optional<Index> index_;
+};
+
+}